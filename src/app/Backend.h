@@ -0,0 +1,96 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2019 casey langen
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the author nor the names of other contributors may
+//      be used to endorse or promote products derived from this software
+//      without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "cmd.h"
+
+#include <cstdint>
+
+namespace cmd {
+    /* a Backend knows how to enumerate the connected outputs and change
+    their brightness. cmd:: picks one at startup; see cmd.cpp. */
+    class Backend {
+        public:
+            virtual ~Backend() {
+            }
+
+            using Visitor = std::function<bool(const Monitor&)>;
+
+            /* every output the server knows about, connected or not */
+            virtual std::vector<Monitor> Query(Probe probe) = 0;
+
+            /* hands over the outputs one at a time, in the same order, and
+            stops probing as soon as `visit` returns false. details that
+            come late in a probe (e.g. the refresh rate) may be missing. */
+            virtual void Visit(Probe probe, const Visitor& visit) {
+                for (auto& monitor : this->Query(probe)) {
+                    if (!visit(monitor)) {
+                        return;
+                    }
+                }
+            }
+
+            /* one write per CRTC, already clamped; should be applied in as
+            few round trips as the backend allows. */
+            virtual void Update(const std::vector<Write>& writes) = 0;
+
+            /* a value that changes whenever the outputs, or the CRTCs driving
+            them, may have; costs a round trip at most. 0 if the backend can't
+            tell without querying, in which case DeviceCache isn't used. */
+            virtual uint64_t Configuration() {
+                return 0;
+            }
+
+            /* re-reads the brightness of `monitors`, from a query made while
+            Configuration() returned what it just did, and makes them
+            writable without querying again. false if it can't. */
+            virtual bool Refresh(std::vector<Monitor>& monitors) {
+                return false;
+            }
+
+            /* see cmd::maxFrameRate() */
+            virtual int MaxFrameRate() const {
+                return 0;
+            }
+
+            /* called from another thread while Query() may be running */
+            virtual void Cancel() {
+            }
+
+            virtual std::unique_ptr<Watcher> Watch(std::function<void()> changed) {
+                return nullptr;
+            }
+    };
+}
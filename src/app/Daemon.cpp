@@ -0,0 +1,422 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2019 casey langen
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the author nor the names of other contributors may
+//      be used to endorse or promote products derived from this software
+//      without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include "Daemon.h"
+#include "ipc.h"
+#include "str.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <poll.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/* a client that sends this much without a newline is misbehaving */
+static const size_t MAX_REQUEST_SIZE = 4096;
+static const auto POLL_INTERVAL = std::chrono::milliseconds(1000);
+
+namespace ipc {
+    Daemon::Daemon() : socketPath(path()) {
+    }
+
+    Daemon::~Daemon() {
+        for (auto& it : this->clients) {
+            close(it.first);
+        }
+        if (this->listenFd >= 0) {
+            close(this->listenFd);
+            unlink(this->socketPath.c_str());
+        }
+        for (int fd : this->changedFds) {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+    }
+
+    bool Daemon::Listen() {
+        ipc::Client other;
+        if (other.Connect()) {
+            std::cerr << "xdimmer is already running on " << this->socketPath << "\n";
+            return false;
+        }
+
+        sockaddr_un address = { };
+        if (this->socketPath.size() >= sizeof(address.sun_path)) {
+            std::cerr << "socket path is too long: " << this->socketPath << "\n";
+            return false;
+        }
+        address.sun_family = AF_UNIX;
+        strcpy(address.sun_path, this->socketPath.c_str());
+
+        /* nobody answered, so whatever's there is left over from a daemon
+        that didn't exit cleanly */
+        unlink(this->socketPath.c_str());
+
+        int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+        mode_t mask = umask(0077);
+        bool bound = fd >= 0 && bind(fd, (sockaddr*) &address, sizeof(address)) == 0;
+        umask(mask);
+
+        if (!bound || listen(fd, SOMAXCONN) != 0) {
+            std::cerr << "could not listen on " << this->socketPath << ": " << strerror(errno) << "\n";
+            if (fd >= 0) {
+                close(fd);
+            }
+            return false;
+        }
+
+        this->listenFd = fd;
+        return true;
+    }
+
+    void Daemon::Run() {
+        sigset_t signals;
+        sigemptyset(&signals);
+        sigaddset(&signals, SIGINT);
+        sigaddset(&signals, SIGTERM);
+        pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+        int signalFd = signalfd(-1, &signals, SFD_CLOEXEC);
+
+        if (pipe2(this->changedFds, O_CLOEXEC | O_NONBLOCK) != 0) {
+            return;
+        }
+
+        int changed = this->changedFds[1];
+        auto watcher = cmd::watch([changed]() {
+            char c = 0;
+            while (::write(changed, &c, 1) == -1 && errno == EINTR) { }
+        });
+
+        this->polling = !watcher;
+        this->transition.reset(new cmd::Transition(cmd::maxFrameRate()));
+        this->Refresh();
+
+        std::vector<pollfd> fds;
+        while (true) {
+            fds.clear();
+            fds.push_back({ signalFd, POLLIN, 0 });
+            fds.push_back({ this->changedFds[0], POLLIN, 0 });
+            fds.push_back({ this->listenFd, POLLIN, 0 });
+            fds.push_back({ this->transition->Fd(), POLLIN, 0 });
+            for (auto& it : this->clients) {
+                short events = POLLIN | (it.second.out.empty() ? 0 : POLLOUT);
+                fds.push_back({ it.first, events, 0 });
+            }
+
+            int timeout = this->transition->Timeout();
+            if (poll(fds.data(), fds.size(), timeout) < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                break;
+            }
+
+            if (fds[0].revents) {
+                break;
+            }
+
+            if (fds[1].revents) {
+                char buffer[64];
+                while (read(this->changedFds[0], buffer, sizeof(buffer)) > 0) { }
+                this->stale = true;
+            }
+
+            if (fds[2].revents & POLLIN) {
+                this->Accept();
+            }
+
+            if ((fds[3].revents & POLLIN) || timeout >= 0) {
+                this->writes = this->transition->Frame();
+            }
+
+            for (size_t i = 4; i < fds.size(); i++) {
+                if (fds[i].revents & (POLLIN | POLLHUP | POLLERR)) {
+                    auto it = this->clients.find(fds[i].fd);
+                    if (!this->Read(it->first, it->second)) {
+                        close(it->first);
+                        this->clients.erase(it);
+                    }
+                }
+            }
+
+            /* everything asked for in this pass goes out as one batch, and
+            only then are the requests acknowledged */
+            if (!this->writes.empty()) {
+                cmd::Deadline deadline(cmd::Deadline::DEFAULT_MS);
+                cmd::update(this->writes);
+                this->writes.clear();
+            }
+
+            for (auto it = this->clients.begin(); it != this->clients.end(); ) {
+                if (!it->second.out.empty() && !this->Write(it->first, it->second)) {
+                    close(it->first);
+                    it = this->clients.erase(it);
+                }
+                else {
+                    ++it;
+                }
+            }
+        }
+
+        if (signalFd >= 0) {
+            close(signalFd);
+        }
+    }
+
+    void Daemon::Accept() {
+        while (true) {
+            int fd = accept4(this->listenFd, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK);
+            if (fd < 0) {
+                return;
+            }
+
+            /* the socket should only be reachable by us anyway, but it may
+            live in /tmp */
+            ucred peer;
+            socklen_t size = sizeof(peer);
+            if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &peer, &size) != 0 ||
+                peer.uid != getuid())
+            {
+                close(fd);
+                continue;
+            }
+
+            this->clients[fd];
+        }
+    }
+
+    bool Daemon::Read(int fd, Client& client) {
+        char buffer[16 * 1024];
+        ssize_t count = recv(fd, buffer, sizeof(buffer), 0);
+        if (count < 0) {
+            return errno == EAGAIN || errno == EINTR;
+        }
+
+        client.in.append(buffer, (size_t) count);
+
+        size_t start = 0, end;
+        while ((end = client.in.find('\n', start)) != std::string::npos) {
+            this->Handle(str::view(client.in.data() + start, end - start), client.out);
+            start = end + 1;
+        }
+        client.in.erase(0, start);
+
+        return count > 0 && client.in.size() <= MAX_REQUEST_SIZE;
+    }
+
+    bool Daemon::Write(int fd, Client& client) {
+        ssize_t count = send(fd, client.out.data(), client.out.size(), MSG_NOSIGNAL);
+        if (count < 0) {
+            return errno == EAGAIN || errno == EINTR;
+        }
+        client.out.erase(0, (size_t) count);
+        return true;
+    }
+
+    void Daemon::Refresh() {
+        cmd::Deadline deadline(cmd::Deadline::DEFAULT_MS);
+
+        /* don't let a requery clobber values we haven't written yet */
+        if (!this->writes.empty()) {
+            cmd::update(this->writes);
+            this->writes.clear();
+        }
+
+        auto monitors = cmd::query();
+        if (!cmd::Deadline::Expired()) {
+            this->monitors = std::move(monitors);
+        }
+
+        /* either way, don't retry on every request while the server is stuck */
+        this->refreshed = Clock::now();
+        this->stale = false;
+    }
+
+    /* someone else (the ui, xrandr) may have changed these since we last
+    looked. outputs we're fading, or have a write queued for, are left be;
+    the model has where they're headed, which is newer. updates both `found`
+    and the model. */
+    void Daemon::Reread(std::vector<Monitor>& found) {
+        std::vector<Monitor> current;
+        for (auto& f : found) {
+            bool queued = std::any_of(
+                this->writes.begin(),
+                this->writes.end(),
+                [&f](const cmd::Write& w) { return w.monitor.name == f.name; });
+
+            if (!queued && !this->transition->Fading(f.name)) {
+                current.push_back(f);
+            }
+        }
+
+        cmd::Deadline deadline(cmd::Deadline::DEFAULT_MS);
+        if (current.empty() || !cmd::refresh(current)) {
+            return;
+        }
+
+        for (auto& c : current) {
+            for (auto& m : this->monitors) {
+                if (m.name == c.name) {
+                    m.brightness = c.brightness;
+                }
+            }
+            for (auto& f : found) {
+                if (f.name == c.name) {
+                    f.brightness = c.brightness;
+                }
+            }
+        }
+    }
+
+    void Daemon::Set(Monitor& monitor, float brightness, int fadeMs, cmd::Easing easing) {
+        auto queued = std::find_if(
+            this->writes.begin(),
+            this->writes.end(),
+            [&monitor](const cmd::Write& w) { return w.monitor.name == monitor.name; });
+
+        if (fadeMs > 0) {
+            /* starts from the last value written, or the fade's position */
+            Monitor from = monitor;
+            if (queued != this->writes.end()) {
+                from.brightness = queued->brightness;
+                this->writes.erase(queued);
+            }
+            this->transition->Start({ { from, brightness } }, fadeMs, easing);
+        }
+        else {
+            this->transition->Stop(monitor.name);
+            if (queued != this->writes.end()) {
+                queued->brightness = brightness;
+            }
+            else {
+                this->writes.push_back({ monitor, brightness });
+            }
+        }
+
+        /* the model has the target, even while fading */
+        monitor.brightness = brightness;
+    }
+
+    void Daemon::Handle(const str::view& request, std::string& response) {
+        trace::Span span("ipc", "request");
+
+        /* a fade in progress would read back as wherever it's got to */
+        bool due = this->polling &&
+            !this->transition->Active() &&
+            Clock::now() - this->refreshed > POLL_INTERVAL;
+
+        if (this->stale || due) {
+            this->Refresh();
+        }
+
+        static const size_t MAX_ARGS = 5;
+        str::view args[MAX_ARGS + 1];
+        size_t count = 0;
+        str::tokenizer tokens(request, " ");
+        while (count <= MAX_ARGS && tokens.next(args[count])) {
+            ++count;
+        }
+        const str::view& op = args[0];
+
+        if (op == "l" && count == 1) {
+            this->Reread(this->monitors);
+            response += '+';
+            for (size_t i = 0; i < this->monitors.size(); i++) {
+                auto& m = this->monitors[i];
+                response += (i ? " " : "") + m.name + "=" + str::fmt("%g", m.brightness);
+            }
+        }
+        else if (op == "g" && count == 2) {
+            auto found = cmd::resolve(this->monitors, args[1].str());
+            if (found.empty()) {
+                response += "-could not find device=" + args[1].str();
+            }
+            else {
+                this->Reread(found);
+                response += '+';
+                for (size_t i = 0; i < found.size(); i++) {
+                    response += (i ? " " : "") + str::fmt("%g", found[i].brightness);
+                }
+            }
+        }
+        else if ((op == "s" || op == "d") && count >= 3 && count <= 5) {
+            float value;
+            bool valid = str::parse(args[2], value);
+
+            int fadeMs = 0;
+            if (count > 3) {
+                valid = valid && str::parse(args[3], fadeMs) && fadeMs >= 0;
+            }
+
+            cmd::Easing easing = cmd::Easing::InOut;
+            if (count > 4) {
+                valid = valid && cmd::parseEasing(args[4].str(), easing);
+            }
+
+            auto found = cmd::resolve(this->monitors, args[1].str());
+            if (!valid) {
+                response += "-invalid arguments '" + request.str() + "'";
+            }
+            else if (found.empty()) {
+                response += "-could not find device=" + args[1].str();
+            }
+            else {
+                this->Reread(found);
+                for (auto& f : found) {
+                    for (auto& m : this->monitors) {
+                        if (m.name == f.name) {
+                            float target = (op == "d") ? m.brightness + value : value;
+                            this->Set(m, cmd::clamp(target), fadeMs, easing);
+                        }
+                    }
+                }
+                response += '+';
+            }
+        }
+        else {
+            response += "-bad request '" + request.str() + "'";
+        }
+
+        response += '\n';
+    }
+}
@@ -0,0 +1,97 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2019 casey langen
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the author nor the names of other contributors may
+//      be used to endorse or promote products derived from this software
+//      without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "cmd.h"
+#include "Transition.h"
+#include "str.h"
+
+#include <chrono>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace ipc {
+    /* `xdimmer --daemon`: keeps the backend and a model of the outputs warm,
+    and serves requests (see ipc.h) from any number of clients on a single
+    thread. the model is refreshed when the server reports a change, or at
+    most once a second when the backend can't report them. the server
+    doesn't report gamma changes, so the brightness of the outputs any
+    request is about is re-read first, where the backend allows.
+
+    all writes requested during one pass over the ready clients are applied
+    as one cmd::update() batch, after which their responses are sent; a
+    response to `s` or `d` therefore means the value has been applied. fade
+    frames are driven by the same loop, and go out in the same batches. */
+    class Daemon {
+        public:
+            Daemon();
+            ~Daemon();
+
+            /* false, after saying why on stderr, if another daemon already
+            owns the socket or it can't be created */
+            bool Listen();
+
+            /* until SIGINT or SIGTERM */
+            void Run();
+
+        private:
+            struct Client {
+                std::string in, out;
+            };
+
+            void Accept();
+            bool Read(int fd, Client& client);
+            bool Write(int fd, Client& client);
+            void Handle(const str::view& request, std::string& response);
+            void Refresh();
+            void Reread(std::vector<Monitor>& found);
+            void Set(Monitor& monitor, float brightness, int fadeMs, cmd::Easing easing);
+
+            using Clock = std::chrono::steady_clock;
+
+            std::string socketPath;
+            int listenFd = -1;
+            int changedFds[2] = { -1, -1 };
+            std::map<int, Client> clients;
+            std::vector<Monitor> monitors;
+            std::vector<cmd::Write> writes;
+            std::unique_ptr<cmd::Transition> transition;
+            Clock::time_point refreshed;
+            bool stale = true;
+            bool polling = false;
+    };
+}
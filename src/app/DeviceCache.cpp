@@ -0,0 +1,206 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2019 casey langen
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the author nor the names of other contributors may
+//      be used to endorse or promote products derived from this software
+//      without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include "DeviceCache.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace cmd {
+    static const char MAGIC[8] = { 'x', 'd', 'i', 'm', 'd', 'e', 'v', '\0' };
+    static const uint32_t VERSION = 1;
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t count;
+        uint64_t stamp;
+        char display[64];
+    };
+
+    struct Entry {
+        char name[64];
+        int32_t crtc, x, y, width, height;
+        float brightness;
+        float gamma[3];
+        float refresh;
+    };
+
+    /* the cache is only valid for the display it was written for */
+    static bool display(char (&out)[64]) {
+        const char* env = getenv("DISPLAY");
+        std::string value = env ? env : "";
+        if (value.size() >= sizeof(out)) {
+            return false;
+        }
+        memset(out, 0, sizeof(out));
+        memcpy(out, value.data(), value.size());
+        return true;
+    }
+
+    std::string DeviceCache::DefaultPath() {
+        const char* dir = getenv("XDG_RUNTIME_DIR");
+        if (dir && *dir) {
+            return std::string(dir) + "/xdimmer-devices";
+        }
+        return "/tmp/xdimmer-" + std::to_string(getuid()) + "-devices";
+    }
+
+    DeviceCache::DeviceCache(const std::string& path)
+    : path(path) {
+    }
+
+    bool DeviceCache::Load(uint64_t stamp, std::vector<Monitor>& monitors) const {
+        Header expected;
+        if (!display(expected.display)) {
+            return false;
+        }
+
+        /* without XDG_RUNTIME_DIR the path is a predictable one in /tmp, so
+        only trust a regular file that's ours, and only we can write */
+        int fd = open(this->path.c_str(), O_RDONLY | O_CLOEXEC | O_NOFOLLOW);
+        if (fd < 0) {
+            return false;
+        }
+
+        struct stat st;
+        if (fstat(fd, &st) != 0 ||
+            !S_ISREG(st.st_mode) ||
+            st.st_uid != getuid() ||
+            (st.st_mode & (S_IWGRP | S_IWOTH)) ||
+            (size_t) st.st_size < sizeof(Header))
+        {
+            close(fd);
+            return false;
+        }
+
+        const size_t size = (size_t) st.st_size;
+        void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (mapped == MAP_FAILED) {
+            return false;
+        }
+
+        const Header* header = (const Header*) mapped;
+        const Entry* entries = (const Entry*) (header + 1);
+
+        bool valid =
+            memcmp(header->magic, MAGIC, sizeof(MAGIC)) == 0 &&
+            header->version == VERSION &&
+            header->stamp == stamp &&
+            memcmp(header->display, expected.display, sizeof(expected.display)) == 0 &&
+            size == sizeof(Header) + header->count * sizeof(Entry);
+
+        if (valid) {
+            monitors.clear();
+            monitors.reserve(header->count);
+            for (uint32_t i = 0; i < header->count; i++) {
+                const Entry& e = entries[i];
+                Monitor m;
+                m.name.assign(e.name, strnlen(e.name, sizeof(e.name)));
+                m.crtc = e.crtc;
+                m.x = e.x;
+                m.y = e.y;
+                m.width = e.width;
+                m.height = e.height;
+                m.brightness = e.brightness;
+                memcpy(m.gamma, e.gamma, sizeof(m.gamma));
+                m.refresh = e.refresh;
+                monitors.push_back(m);
+            }
+        }
+
+        munmap(mapped, size);
+        return valid;
+    }
+
+    bool DeviceCache::Store(uint64_t stamp, const std::vector<Monitor>& monitors) const {
+        std::vector<char> buffer(sizeof(Header) + monitors.size() * sizeof(Entry), 0);
+        Header* header = (Header*) buffer.data();
+        Entry* entries = (Entry*) (header + 1);
+
+        memcpy(header->magic, MAGIC, sizeof(MAGIC));
+        header->version = VERSION;
+        header->count = (uint32_t) monitors.size();
+        header->stamp = stamp;
+        if (!display(header->display)) {
+            return false;
+        }
+
+        for (size_t i = 0; i < monitors.size(); i++) {
+            const Monitor& m = monitors[i];
+            Entry& e = entries[i];
+            if (m.name.size() >= sizeof(e.name)) {
+                return false;
+            }
+            memcpy(e.name, m.name.data(), m.name.size());
+            e.crtc = m.crtc;
+            e.x = m.x;
+            e.y = m.y;
+            e.width = m.width;
+            e.height = m.height;
+            e.brightness = m.brightness;
+            memcpy(e.gamma, m.gamma, sizeof(e.gamma));
+            e.refresh = m.refresh;
+        }
+
+        /* a fresh file (O_EXCL, 0600) that nobody else can have put there */
+        std::string temp = this->path + ".XXXXXX";
+        int fd = mkostemp(&temp[0], O_CLOEXEC);
+        if (fd < 0) {
+            return false;
+        }
+
+        size_t offset = 0;
+        while (offset < buffer.size()) {
+            ssize_t count = write(fd, buffer.data() + offset, buffer.size() - offset);
+            if (count <= 0) {
+                break;
+            }
+            offset += (size_t) count;
+        }
+        close(fd);
+
+        if (offset != buffer.size() || rename(temp.c_str(), this->path.c_str()) != 0) {
+            unlink(temp.c_str());
+            return false;
+        }
+        return true;
+    }
+}
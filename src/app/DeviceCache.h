@@ -0,0 +1,73 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2019 casey langen
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the author nor the names of other contributors may
+//      be used to endorse or promote products derived from this software
+//      without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "cmd.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace cmd {
+    /* the outputs from the last query, kept in a small file so short-lived
+    processes (i.e. the CLI) can resolve devices without querying them again.
+    the file holds fixed-size records and is read by mapping it, so loading
+    is a copy, not a parse.
+
+    entries are stamped with the backend's configuration stamp (see
+    Backend::Configuration()) and the display they came from, and Load()
+    refuses them once either differs. brightness is as it was last seen;
+    callers should re-read it if they need it to be current. */
+    class DeviceCache {
+        public:
+            /* $XDG_RUNTIME_DIR/xdimmer-devices, or a per-user path in /tmp */
+            static std::string DefaultPath();
+
+            DeviceCache(const std::string& path = DefaultPath());
+
+            /* false if there's no cache, it's for another display or
+            configuration, or it isn't a regular file that only we own and
+            can write */
+            bool Load(uint64_t stamp, std::vector<Monitor>& monitors) const;
+
+            /* replaces the file atomically, so concurrent readers see the
+            old entries or the new ones. outputs with names too long for a
+            record aren't cached at all. */
+            bool Store(uint64_t stamp, const std::vector<Monitor>& monitors) const;
+
+        private:
+            std::string path;
+    };
+}
@@ -0,0 +1,359 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2019 casey langen
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the author nor the names of other contributors may
+//      be used to endorse or promote products derived from this software
+//      without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include "Engine.h"
+#include "Transition.h"
+
+#include <algorithm>
+
+namespace cmd {
+    using Lock = std::unique_lock<std::mutex>;
+
+    Engine::Engine(Callback completed, int writeIntervalMs)
+    : completed(completed)
+    , writeInterval(std::chrono::milliseconds(std::max(0, writeIntervalMs))) {
+        this->thread = std::thread([this]() { this->Run(); });
+    }
+
+    Engine::~Engine() {
+        {
+            Lock lock(this->lock);
+            this->quit = true;
+            if (this->queryInFlight) {
+                cmd::cancel();
+            }
+        }
+        this->wakeup.notify_all();
+        this->thread.join();
+    }
+
+    void Engine::Refresh() {
+        this->EnqueueQuery(Probe::Current);
+    }
+
+    void Engine::Rescan() {
+        this->EnqueueQuery(Probe::Full);
+    }
+
+    void Engine::Validate() {
+        {
+            Lock lock(this->lock);
+            if (this->queryInFlight || this->QueryQueued()) {
+                return;
+            }
+            Task task;
+            task.type = Task::Validate;
+            task.probe = Probe::Current;
+            this->queue.push_back(task);
+        }
+        this->wakeup.notify_all();
+    }
+
+    void Engine::Update(const Monitor& monitor, float brightness) {
+        this->Update(std::vector<Write>{ { monitor, brightness } });
+    }
+
+    void Engine::Update(const std::vector<Write>& writes) {
+        if (writes.empty()) {
+            return;
+        }
+        {
+            Lock lock(this->lock);
+
+            for (auto& w : writes) {
+                this->DropFades(w.monitor.name);
+
+                auto queued = std::find_if(
+                    this->queue.begin(),
+                    this->queue.end(),
+                    [&w](const Task& task) {
+                        return task.type == Task::Write &&
+                            task.monitor.name == w.monitor.name;
+                    });
+
+                if (queued != this->queue.end()) {
+                    queued->monitor = w.monitor;
+                    queued->brightness = w.brightness;
+                }
+                else {
+                    Task task;
+                    task.type = Task::Write;
+                    task.monitor = w.monitor;
+                    task.brightness = w.brightness;
+                    this->queue.push_back(task);
+                }
+            }
+
+            /* results of any query started before this point don't reflect
+            this write; make sure they're not delivered (or applied). */
+            ++this->generation;
+        }
+        this->wakeup.notify_all();
+    }
+
+    void Engine::Fade(const std::vector<Write>& targets, int durationMs, Easing easing) {
+        if (targets.empty()) {
+            return;
+        }
+        {
+            Lock lock(this->lock);
+
+            /* a direct write that's still queued would otherwise land after
+            the fade has started, and cut it short */
+            auto end = std::remove_if(
+                this->queue.begin(),
+                this->queue.end(),
+                [&targets](const Task& task) {
+                    return task.type == Task::Write &&
+                        std::any_of(targets.begin(), targets.end(), [&task](const Write& w) {
+                            return w.monitor.name == task.monitor.name;
+                        });
+                });
+
+            this->queue.erase(end, this->queue.end());
+
+            for (auto& t : targets) {
+                this->DropFades(t.monitor.name);
+            }
+
+            this->fades.push_back({ targets, durationMs, easing });
+            ++this->generation;
+        }
+        this->wakeup.notify_all();
+    }
+
+    /* forgets fades of `name` the worker hasn't picked up yet; call with the lock held */
+    void Engine::DropFades(const std::string& name) {
+        for (auto& request : this->fades) {
+            auto& targets = request.targets;
+            targets.erase(
+                std::remove_if(targets.begin(), targets.end(), [&name](const Write& w) {
+                    return w.monitor.name == name;
+                }),
+                targets.end());
+        }
+    }
+
+    bool Engine::QueryQueued() {
+        return std::any_of(this->queue.begin(), this->queue.end(), [](const Task& task) {
+            return task.type != Task::Write;
+        });
+    }
+
+    bool Engine::IsCurrent(uint64_t generation) {
+        Lock lock(this->lock);
+        return generation == this->generation;
+    }
+
+    void Engine::EnqueueQuery(Probe probe) {
+        {
+            Lock lock(this->lock);
+
+            /* any query that hasn't started yet would return stale data, so
+            replace it (and any validation, which a query covers); keep the
+            more expensive probe if one was asked for. */
+            auto end = std::remove_if(
+                this->queue.begin(),
+                this->queue.end(),
+                [&probe](const Task& task) {
+                    if (task.type == Task::Validate) {
+                        return true;
+                    }
+                    if (task.type == Task::Query) {
+                        if (task.probe == Probe::Full) {
+                            probe = Probe::Full;
+                        }
+                        return true;
+                    }
+                    return false;
+                });
+
+            this->queue.erase(end, this->queue.end());
+
+            Task task;
+            task.type = Task::Query;
+            task.probe = probe;
+            this->queue.push_back(task);
+
+            ++this->generation;
+
+            if (this->queryInFlight) {
+                cmd::cancel();
+            }
+        }
+        this->wakeup.notify_all();
+    }
+
+    void Engine::Run() {
+        Transition transition(cmd::maxFrameRate());
+        std::vector<Monitor> last; /* as of the last query; what Validate() re-reads */
+
+        while (true) {
+            Task query;
+            std::vector<Write> batch;
+            bool haveQuery = false;
+            uint64_t generation;
+
+            {
+                Lock lock(this->lock);
+
+                /* writes go first, as soon as their output's rate limit
+                allows, and all writes that are due go together; then the
+                next frame of any running fade. queries are low priority and
+                only run when neither is pending, since they'd be stale
+                anyway. a write stays queued while it waits for its slot, so
+                Update() can keep replacing its value in the meantime. */
+                while (!this->quit) {
+                    for (auto& request : this->fades) {
+                        transition.Start(request.targets, request.durationMs, request.easing);
+                    }
+                    this->fades.clear();
+
+                    auto now = Clock::now();
+                    auto wake = Clock::time_point::max();
+                    bool writesPending = false;
+
+                    for (auto it = this->queue.begin(); it != this->queue.end(); ) {
+                        if (it->type == Task::Write) {
+                            writesPending = true;
+                            auto last = this->lastWrite.find(it->monitor.name);
+                            if (last == this->lastWrite.end() ||
+                                last->second + this->writeInterval <= now)
+                            {
+                                transition.Stop(it->monitor.name);
+                                batch.push_back({ it->monitor, it->brightness });
+                                it = this->queue.erase(it);
+                                continue;
+                            }
+                            wake = std::min(wake, last->second + this->writeInterval);
+                        }
+                        ++it;
+                    }
+
+                    if (!batch.empty() || transition.Active()) {
+                        break;
+                    }
+
+                    if (!writesPending && !this->queue.empty()) {
+                        query = this->queue.front(); /* the (only) query or validation */
+                        this->queue.pop_front();
+                        haveQuery = true;
+                        break;
+                    }
+
+                    if (wake == Clock::time_point::max()) {
+                        this->wakeup.wait(lock);
+                    }
+                    else {
+                        this->wakeup.wait_until(lock, wake);
+                    }
+                }
+
+                if (this->quit) {
+                    return;
+                }
+
+                auto now = Clock::now();
+                for (auto& w : batch) {
+                    this->lastWrite[w.monitor.name] = now;
+                }
+
+                this->queryInFlight = haveQuery;
+                generation = this->generation;
+            }
+
+            if (batch.empty() && transition.Active()) {
+                /* at most a frame; anything queued meanwhile waits that long */
+                transition.Wait();
+                batch = transition.Frame();
+            }
+
+            if (!batch.empty()) {
+                cmd::Deadline deadline(cmd::Deadline::DEFAULT_MS);
+                cmd::update(batch);
+                continue;
+            }
+
+            if (!haveQuery) {
+                continue;
+            }
+
+            Result result;
+            result.probe = query.probe;
+            result.generation = generation;
+            bool expired;
+            {
+                cmd::Deadline deadline((query.probe == Probe::Full)
+                    ? cmd::Deadline::RESCAN_MS : cmd::Deadline::DEFAULT_MS);
+                if (query.type == Task::Validate) {
+                    result.monitors = last;
+                    if (last.empty() || !cmd::refresh(result.monitors)) {
+                        result.monitors = cmd::query();
+                    }
+                }
+                else {
+                    result.monitors = (query.probe == Probe::Full) ? cmd::rescan() : cmd::query();
+                }
+                expired = cmd::Deadline::Expired();
+            }
+
+            bool current;
+            {
+                Lock lock(this->lock);
+                this->queryInFlight = false;
+                /* a list cut short would look like unplugged outputs; keep
+                showing the last good one until the next poll */
+                current = (generation == this->generation) && !this->quit && !expired;
+
+                /* overtaken by a write. the server may have reported a change
+                that this query was meant to pick up, and with notifications
+                there's no poll to catch up later, so run it again once the
+                writes are done, unless a newer one is already queued. */
+                if (!current && !this->quit && !expired && !this->QueryQueued()) {
+                    Task task;
+                    task.type = Task::Query;
+                    task.probe = Probe::Current;
+                    this->queue.push_back(task);
+                }
+            }
+
+            if (current) {
+                /* not before: a cancelled query comes back short without
+                having expired, and Validate() would keep re-reading that */
+                last = result.monitors;
+                this->completed(result);
+            }
+        }
+    }
+}
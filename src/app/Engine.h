@@ -0,0 +1,147 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2019 casey langen
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the author nor the names of other contributors may
+//      be used to endorse or promote products derived from this software
+//      without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "cmd.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace cmd {
+    /* runs queries and updates on a background thread so the caller never
+    blocks on the backend. query results are handed to
+    `completed` on the worker thread; the caller is expected to marshal
+    them to wherever they're needed (e.g. the ui thread). the worker is the
+    only thread that touches the backend while an Engine is alive.
+
+    a new Refresh() supersedes any query that's queued or in flight; the
+    in-flight one is cancelled (e.g. its xrandr process is killed) and its
+    results are dropped.
+
+    the caller is expected to keep its own model of the outputs and update
+    it optimistically when it writes; writes are not followed by a query.
+    queries are low priority: they only run when no writes are pending, and
+    a write invalidates the results of any query started before it; such a
+    query is run again once the writes are done, so a change the server
+    reported meanwhile isn't lost.
+
+    writes are coalesced per output: if a write to the same output is still
+    queued, its value is replaced rather than a new write being added, and
+    each output is written at most once per write interval. holding down a
+    key therefore never builds a backlog; the latest value wins.
+
+    while a fade is running, the worker wakes once per frame to apply it,
+    along with anything else that's been queued in the meantime; queries
+    wait until it's finished. */
+    class Engine {
+        public:
+            struct Result {
+                std::vector<Monitor> monitors;
+                Probe probe;
+                uint64_t generation;
+            };
+
+            using Callback = std::function<void(const Result&)>;
+
+            static const int DEFAULT_WRITE_INTERVAL_MS = 33;
+
+            Engine(Callback completed, int writeIntervalMs = DEFAULT_WRITE_INTERVAL_MS);
+            ~Engine();
+
+            void Refresh();
+            void Rescan();
+
+            /* re-reads the brightness of the outputs the last query found,
+            without listing them again (see cmd::refresh()), and delivers
+            them like a query. for catching changes the server doesn't
+            notify us of, e.g. gamma set by another process; cheap enough to
+            do every few seconds. does nothing if a query is already due. */
+            void Validate();
+
+            /* writes are never cancelled (though they may be coalesced).
+            writes that become due together are applied as one batch; see
+            cmd::update(). writing nothing does nothing. */
+            void Update(const Monitor& monitor, float brightness);
+            void Update(const std::vector<Write>& writes);
+
+            /* like Update(), but each output fades to its value over
+            `durationMs`; see Transition. a later Update() or Fade() of the
+            same output takes over from wherever the fade got to. */
+            void Fade(const std::vector<Write>& targets, int durationMs, Easing easing);
+
+            /* false if anything has been written or queried since `generation`
+            was issued, i.e. a Result with it is stale and shouldn't be
+            applied. may be called from any thread. */
+            bool IsCurrent(uint64_t generation);
+
+        private:
+            struct FadeRequest {
+                std::vector<Write> targets;
+                int durationMs;
+                Easing easing;
+            };
+
+            struct Task {
+                enum Type { Query, Validate, Write } type;
+                Probe probe;
+                Monitor monitor;
+                float brightness;
+            };
+
+            void EnqueueQuery(Probe probe);
+            bool QueryQueued(); /* with the lock held */
+            void DropFades(const std::string& name);
+            void Run();
+
+            using Clock = std::chrono::steady_clock;
+
+            Callback completed;
+            Clock::duration writeInterval;
+            std::map<std::string, Clock::time_point> lastWrite;
+            std::mutex lock;
+            std::condition_variable wakeup;
+            std::deque<Task> queue;
+            std::vector<FadeRequest> fades; /* not yet handed to the worker's Transition */
+            uint64_t generation = 0; /* of the most recently requested query */
+            bool queryInFlight = false;
+            bool quit = false;
+            std::thread thread;
+    };
+}
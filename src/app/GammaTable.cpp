@@ -0,0 +1,130 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2019 casey langen
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the author nor the names of other contributors may
+//      be used to endorse or promote products derived from this software
+//      without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include "GammaTable.h"
+
+#include <algorithm>
+#include <cmath>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace cmd {
+    int GammaTable::Quantize(float brightness) {
+        brightness = std::max(0.0f, std::min(brightness, 1.0f));
+        return (int) std::lround(brightness * BRIGHTNESS_STEPS);
+    }
+
+    const uint16_t* GammaTable::Ramp(int size, double exponent, float brightness) {
+        const int e = (int) std::lround(exponent * 1000.0);
+        const int step = Quantize(brightness);
+        const RampKey key(size, e, step);
+
+        auto it = this->ramps.find(key);
+        if (it != this->ramps.end()) {
+            ++this->hits;
+            it->second.used = ++this->clock;
+            return it->second.values.data();
+        }
+
+        ++this->misses;
+
+        /* recycle the least recently used ramp's storage */
+        std::vector<uint16_t> values;
+        if (this->ramps.size() >= MAX_RAMPS) {
+            auto oldest = std::min_element(
+                this->ramps.begin(),
+                this->ramps.end(),
+                [](const std::pair<const RampKey, Entry>& a, const std::pair<const RampKey, Entry>& b) {
+                    return a.second.used < b.second.used;
+                });
+            values = std::move(oldest->second.values);
+            this->ramps.erase(oldest);
+        }
+
+        auto& ramp = this->ramps[key];
+        ramp.used = ++this->clock;
+        ramp.values = std::move(values);
+        ramp.values.resize((size_t) size);
+        scaleRamp(
+            this->Curve(size, e).data(),
+            size,
+            (float) step / BRIGHTNESS_STEPS,
+            ramp.values.data());
+
+        return ramp.values.data();
+    }
+
+    const std::vector<float>& GammaTable::Curve(int size, int exponent) {
+        auto& curve = this->curves[CurveKey(size, exponent)];
+        if (curve.empty() && size > 0) {
+            curve.resize((size_t) size);
+            const double e = exponent / 1000.0;
+            const double last = (double) std::max(1, size - 1);
+            for (int i = 0; i < size; i++) {
+                curve[i] = (float) std::pow((double) i / last, e);
+            }
+        }
+        return curve;
+    }
+
+    void scaleRampScalar(const float* curve, int size, float brightness, uint16_t* out) {
+        for (int i = 0; i < size; i++) {
+            out[i] = (uint16_t)(std::min(curve[i] * brightness, 1.0f) * 65535.0f);
+        }
+    }
+
+    void scaleRamp(const float* curve, int size, float brightness, uint16_t* out) {
+        int i = 0;
+#ifdef __SSE2__
+        const __m128 scale = _mm_set1_ps(brightness);
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 max = _mm_set1_ps(65535.0f);
+        /* SSE2 can only pack to *signed* 16 bit with saturation, so shift
+        into that range first, and flip the sign bit back afterwards */
+        const __m128i bias = _mm_set1_epi32(32768);
+        const __m128i sign = _mm_set1_epi16((short) 0x8000);
+        for (; i + 8 <= size; i += 8) {
+            __m128 lo = _mm_mul_ps(_mm_min_ps(_mm_mul_ps(_mm_loadu_ps(curve + i), scale), one), max);
+            __m128 hi = _mm_mul_ps(_mm_min_ps(_mm_mul_ps(_mm_loadu_ps(curve + i + 4), scale), one), max);
+            __m128i packed = _mm_packs_epi32(
+                _mm_sub_epi32(_mm_cvttps_epi32(lo), bias),
+                _mm_sub_epi32(_mm_cvttps_epi32(hi), bias));
+            _mm_storeu_si128((__m128i*)(out + i), _mm_xor_si128(packed, sign));
+        }
+#endif
+        scaleRampScalar(curve + i, size - i, brightness, out + i);
+    }
+}
@@ -0,0 +1,90 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2019 casey langen
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the author nor the names of other contributors may
+//      be used to endorse or promote products derived from this software
+//      without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <tuple>
+#include <vector>
+
+namespace cmd {
+    /* builds and caches 16-bit gamma ramps, the way `xrandr --brightness`
+    computes them: min(position ^ exponent * brightness, 1) * 65535.
+
+    the expensive part, position ^ exponent, only depends on the ramp size
+    and exponent, so it's computed once per pair and kept as a float curve.
+    scaling a curve by a brightness is then a multiply, a min and a
+    conversion per entry, which scaleRamp() does four at a time.
+
+    brightness is quantized to BRIGHTNESS_STEPS, and exponents to three
+    decimal places (the precision xrandr reports them with), so values that
+    are indistinguishable on screen share a ramp. the most recently used
+    ramps are kept. */
+    class GammaTable {
+        public:
+            static const int BRIGHTNESS_STEPS = 4096;
+            static const size_t MAX_RAMPS = 64;
+
+            static int Quantize(float brightness);
+
+            /* the ramp for one channel; only valid until the next call */
+            const uint16_t* Ramp(int size, double exponent, float brightness);
+
+            size_t Hits() const { return this->hits; }
+            size_t Misses() const { return this->misses; }
+
+        private:
+            using CurveKey = std::pair<int, int>; /* size, exponent * 1000 */
+            using RampKey = std::tuple<int, int, int>; /* ... and brightness step */
+
+            struct Entry {
+                std::vector<uint16_t> values;
+                uint64_t used;
+            };
+
+            const std::vector<float>& Curve(int size, int exponent);
+
+            std::map<CurveKey, std::vector<float>> curves;
+            std::map<RampKey, Entry> ramps;
+            uint64_t clock = 0;
+            size_t hits = 0, misses = 0;
+    };
+
+    /* out[i] = min(curve[i] * brightness, 1) * 65535, truncated. SSE2 when
+    the compiler targets it, scalar otherwise; both give identical results. */
+    void scaleRamp(const float* curve, int size, float brightness, uint16_t* out);
+    void scaleRampScalar(const float* curve, int size, float brightness, uint16_t* out);
+}
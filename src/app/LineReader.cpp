@@ -0,0 +1,108 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2019 casey langen
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the author nor the names of other contributors may
+//      be used to endorse or promote products derived from this software
+//      without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include "LineReader.h"
+#include "trace.h"
+
+namespace cmd {
+    LineReader::LineReader(size_t bufferSize) {
+        this->stream.rdbuf()->buffer_size(bufferSize);
+    }
+
+    LineReader& LineReader::Open(
+        const std::string& file,
+        const redi::pstreams::argv_type& argv,
+        redi::pstreams::pmode mode)
+    {
+        this->Close();
+        std::unique_lock<std::mutex> lock(this->lock);
+        uint64_t start = trace::enabled ? trace::now() : 0;
+        this->stream.open(file, argv, mode);
+        this->running = this->stream.is_open();
+        if (trace::enabled) {
+            trace::record("process", "spawn", start, trace::now());
+            this->opened = start;
+            this->firstByte = 0;
+        }
+        return *this;
+    }
+
+    bool LineReader::Next(str::view& line) {
+        const char* data;
+        std::streamsize length;
+        if (this->stream.rdbuf()->read_line(data, length)) {
+            line = str::view(data, (size_t) length);
+            if (trace::enabled && !this->firstByte && this->opened) {
+                /* from asking for the process until its output arrives */
+                this->firstByte = trace::now();
+                trace::record("process", "first byte", this->opened, this->firstByte);
+            }
+            return true;
+        }
+        return false;
+    }
+
+    void LineReader::Close() {
+        {
+            std::unique_lock<std::mutex> lock(this->lock);
+            this->running = false;
+        }
+        if (trace::enabled && this->firstByte) {
+            /* from the first byte to EOF, or to wherever we stopped reading */
+            trace::record("process", "output", this->firstByte, trace::now());
+            this->firstByte = 0;
+        }
+        if (this->stream.is_open()) {
+            trace::Span span("process", "waitpid");
+            this->stream.close();
+        }
+        this->opened = 0;
+        this->stream.clear();
+    }
+
+    void LineReader::SetDeadline(redi::pstreams::clock_type::time_point when) {
+        this->stream.rdbuf()->deadline(when);
+    }
+
+    bool LineReader::Expired() const {
+        return this->stream.rdbuf()->expired();
+    }
+
+    void LineReader::Kill() {
+        std::unique_lock<std::mutex> lock(this->lock);
+        if (this->running) {
+            this->stream.rdbuf()->kill(SIGTERM);
+        }
+    }
+}
@@ -0,0 +1,110 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2019 casey langen
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the author nor the names of other contributors may
+//      be used to endorse or promote products derived from this software
+//      without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "str.h"
+#include "pstream.h"
+
+#include <cstdint>
+#include <mutex>
+
+namespace cmd {
+    /* runs a command and yields its output one line at a time, as views
+    straight into the pipe's read buffer; nothing is copied, and a view is
+    only valid until the next line is read. the buffer is kept between
+    commands, so a long-lived LineReader doesn't allocate in steady state.
+
+        for (auto line : reader.Open(file, argv)) { ... } */
+    class LineReader {
+        public:
+            static const size_t DEFAULT_BUFFER_SIZE = 64 * 1024;
+
+            class iterator {
+                public:
+                    iterator(LineReader* reader = nullptr) : reader(reader) {
+                        ++(*this);
+                    }
+
+                    const str::view& operator*() const {
+                        return this->line;
+                    }
+
+                    iterator& operator++() {
+                        if (this->reader && !this->reader->Next(this->line)) {
+                            this->reader = nullptr;
+                        }
+                        return *this;
+                    }
+
+                    bool operator!=(const iterator& other) const {
+                        return this->reader != other.reader;
+                    }
+
+                private:
+                    LineReader* reader;
+                    str::view line;
+            };
+
+            LineReader(size_t bufferSize = DEFAULT_BUFFER_SIZE);
+
+            LineReader& Open(
+                const std::string& file,
+                const redi::pstreams::argv_type& argv,
+                redi::pstreams::pmode mode = redi::pstreams::pstdout);
+
+            bool Next(str::view& line);
+            void Close();
+
+            /* Next() and Close() give up at `when`, killing the command; set
+            before Open(), it holds until changed. */
+            void SetDeadline(redi::pstreams::clock_type::time_point when);
+
+            /* whether the last command ran into the deadline */
+            bool Expired() const;
+
+            /* sends SIGTERM to the running command, so a blocked Next()
+            returns. the only method that may be called from another thread. */
+            void Kill();
+
+            iterator begin() { return iterator(this); }
+            iterator end() { return iterator(); }
+
+        private:
+            redi::ipstream stream;
+            uint64_t opened = 0, firstByte = 0; /* for tracing */
+            std::mutex lock; /* guards `running`, and the pid for Kill() */
+            bool running = false;
+    };
+}
@@ -0,0 +1,69 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2019 casey langen
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the author nor the names of other contributors may
+//      be used to endorse or promote products derived from this software
+//      without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <chrono>
+
+namespace ui {
+    /* decides when to poll the backend next, for when it can't tell us about
+    changes itself. polls quickly for a few seconds after anything happens
+    (user input, or a poll that turned up an external change), since more is
+    likely to follow; then backs off exponentially, up to a ceiling, while
+    nothing does.
+
+    there's no explicit pause: nothing is polled while the process is
+    stopped (e.g. suspended with ^Z), and the first key press afterwards
+    speeds polling back up. */
+    class PollScheduler {
+        public:
+            static const int FAST_INTERVAL_MS = 150;
+            static const int FAST_WINDOW_MS = 3000;
+            /* see Settings::pollMaxMs */
+            PollScheduler(int maxIntervalMs);
+
+            /* something happened; poll quickly for a while */
+            void Activity();
+
+            /* milliseconds until the next poll; call once per poll */
+            int Next();
+
+        private:
+            using Clock = std::chrono::steady_clock;
+
+            int maxIntervalMs;
+            int intervalMs = FAST_INTERVAL_MS;
+            Clock::time_point fastUntil;
+    };
+}
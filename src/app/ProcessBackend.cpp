@@ -0,0 +1,163 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2019 casey langen
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the author nor the names of other contributors may
+//      be used to endorse or promote products derived from this software
+//      without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include "ProcessBackend.h"
+#include "VerboseParser.h"
+#include "str.h"
+#include "pstream.h"
+#include "trace.h"
+
+#include <cstdlib>
+#include <unistd.h>
+
+/* we're a long-lived process with a fair amount of heap (curses, f8n);
+posix_spawn avoids copying our page tables for every xrandr we run. */
+static const redi::pstreams::pmode PSTDOUT =
+    redi::pstreams::pstdout | redi::pstreams::spawn;
+
+static const redi::pstreams::pmode PSTDIN =
+    redi::pstreams::pstdin | redi::pstreams::spawn;
+
+namespace cmd {
+    /* resolved once per process. we exec xrandr directly, rather than via
+    `/bin/sh -c`, so there's no shell to spawn and nothing to quote. */
+    static const std::string& xrandr() {
+        static const std::string path = []() -> std::string {
+            const char* env = getenv("PATH");
+            for (auto& dir : str::split(env ? env : "/usr/bin:/bin", ":")) {
+                std::string candidate = dir + "/xrandr";
+                if (::access(candidate.c_str(), X_OK) == 0) {
+                    return candidate;
+                }
+            }
+            return "xrandr"; /* let execvp() have a go, and fail */
+        }();
+        return path;
+    }
+
+    static redi::pstreams::argv_type queryArgs(Probe probe) {
+        redi::pstreams::argv_type argv = { "xrandr", "--verbose" };
+        if (probe == Probe::Current) {
+            argv.push_back("--current");
+        }
+        return argv;
+    }
+
+    /* parsing is interleaved with reading, line by line, so rather than a
+    span per line its total is attached to the enclosing span */
+    static void feed(VerboseParser& parser, const str::view& line, long& parseUs) {
+        if (trace::enabled) {
+            uint64_t start = trace::now();
+            parser.Feed(line);
+            parseUs += (long) (trace::now() - start);
+        }
+        else {
+            parser.Feed(line);
+        }
+    }
+
+    /* passes a timeout on to whoever set the deadline */
+    static void expired(const LineReader& reader, trace::Span& span) {
+        if (reader.Expired()) {
+            Deadline::Expire();
+            span.Arg("timed_out", 1);
+        }
+    }
+
+    std::vector<Monitor> ProcessBackend::Query(Probe probe) {
+        trace::Span span("xrandr", "query");
+        long parseUs = 0;
+        VerboseParser parser;
+        this->reader.SetDeadline(Deadline::Current());
+        for (auto line : this->reader.Open(xrandr(), queryArgs(probe), PSTDOUT)) {
+            feed(parser, line, parseUs);
+        }
+        this->reader.Close();
+        expired(this->reader, span);
+        span.Arg("parse_us", parseUs);
+        return parser.Monitors();
+    }
+
+    void ProcessBackend::Visit(Probe probe, const Visitor& visit) {
+        trace::Span span("xrandr", "query");
+        long parseUs = 0;
+        VerboseParser parser(visit);
+        this->reader.SetDeadline(Deadline::Current());
+        for (auto line : this->reader.Open(xrandr(), queryArgs(probe), PSTDOUT)) {
+            feed(parser, line, parseUs);
+            if (parser.Done()) {
+                /* got what we came for; xrandr would otherwise go on to
+                query and print the remaining outputs' properties */
+                this->reader.Kill();
+                break;
+            }
+        }
+        parser.Finish();
+        this->reader.Close();
+        expired(this->reader, span);
+        span.Arg("parse_us", parseUs);
+    }
+
+    void ProcessBackend::Update(const std::vector<Write>& writes) {
+        /* xrandr takes any number of --output clauses, so N outputs cost one
+        process and one round of server requests rather than N. --current, or
+        xrandr makes the server reprobe every output before it writes. */
+        redi::pstreams::argv_type argv = { "xrandr", "--current" };
+        for (auto& w : writes) {
+            argv.push_back("--output");
+            argv.push_back(w.monitor.name);
+            argv.push_back("--brightness");
+            argv.push_back(str::fmt("%f", w.brightness));
+        }
+        trace::Span span("xrandr", "update");
+        span.Arg("outputs", (long) writes.size());
+
+        redi::opstream out;
+        {
+            trace::Span spawn("process", "spawn");
+            out.open(xrandr(), argv, PSTDIN);
+        }
+        trace::Span wait("process", "waitpid");
+        out.rdbuf()->deadline(Deadline::Current());
+        out.close();
+        if (out.rdbuf()->expired()) {
+            Deadline::Expire();
+            span.Arg("timed_out", 1);
+        }
+    }
+
+    void ProcessBackend::Cancel() {
+        this->reader.Kill();
+    }
+}
@@ -0,0 +1,464 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2019 casey langen
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the author nor the names of other contributors may
+//      be used to endorse or promote products derived from this software
+//      without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifdef HAVE_XRANDR
+
+#include "RandrBackend.h"
+#include "trace.h"
+
+#include <cmath>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <thread>
+
+#include <poll.h>
+#include <unistd.h>
+
+namespace cmd {
+    static int ignoreErrors(Display* display, XErrorEvent* error) {
+        /* the default Xlib error handler calls exit(). outputs and CRTCs can
+        disappear out from under us (e.g. a monitor is unplugged between two
+        requests), and that shouldn't take the process down. */
+        return 0;
+    }
+
+    static int lastNonClamped(const unsigned short* ramp, int size) {
+        for (int i = size - 1; i > 0; i--) {
+            if (ramp[i] < 0xffff) {
+                return i;
+            }
+        }
+        return 0;
+    }
+
+    /* the math below mirrors xrandr's set_gamma_info() / set_gamma(): a ramp
+    is modeled as v = brightness * i^exponent per channel, so values we read
+    back agree with `xrandr --verbose`, and values we write are read back by
+    xrandr unchanged. */
+
+    static float brightnessFromRamp(XRRCrtcGamma* gamma) {
+        const int size = gamma->size;
+        const unsigned short* channels[] = { gamma->red, gamma->green, gamma->blue };
+
+        const unsigned short* best = channels[0];
+        int lastBest = lastNonClamped(best, size);
+        for (int c = 1; c < 3; c++) {
+            int last = lastNonClamped(channels[c], size);
+            if (channels[c][last] > best[lastBest]) {
+                best = channels[c];
+                lastBest = last;
+            }
+        }
+
+        if (lastBest == 0) {
+            lastBest = 1;
+        }
+
+        const int middle = lastBest / 2;
+        const double i1 = (double)(middle + 1) / size;
+        const double v1 = (double) best[middle] / 65535.0;
+        const double i2 = (double)(lastBest + 1) / size;
+        const double v2 = (double) best[lastBest] / 65535.0;
+
+        if (v2 < 0.0001) {
+            return 0.0f;
+        }
+        if (lastBest + 1 == size) {
+            return (float) v2;
+        }
+        return (float) std::exp(
+            (std::log(v2) * std::log(i1) - std::log(v1) * std::log(i2)) /
+            std::log(i1 / i2));
+    }
+
+    static double exponentFromRamp(const unsigned short* ramp, int size, float brightness) {
+        const int index = lastNonClamped(ramp, size) / 2;
+        const double value = (double) ramp[index] / brightness / 65535.0;
+        const double position = (double)(index + 1) / size;
+        if (brightness <= 0.0f || value <= 0.0 || position >= 1.0) {
+            return 1.0;
+        }
+        return std::log(value) / std::log(position);
+    }
+
+    /* listens for RandR notify events on a dedicated connection and thread,
+    so the main connection never has to be shared across threads (and we
+    don't need XInitThreads()). a self-pipe is used to wake the thread up
+    when it's time to shut down. */
+    class RandrWatcher: public Watcher {
+        public:
+            RandrWatcher(Display* display, std::function<void()> changed)
+            : display(display), changed(changed) {
+                this->wakeup[0] = this->wakeup[1] = -1;
+                if (::pipe(this->wakeup) == 0) {
+                    XRRSelectInput(
+                        display,
+                        DefaultRootWindow(display),
+                        RRScreenChangeNotifyMask |
+                        RRCrtcChangeNotifyMask |
+                        RROutputChangeNotifyMask);
+                    XFlush(display);
+                    this->thread = std::thread([this]() { this->Run(); });
+                }
+            }
+
+            virtual ~RandrWatcher() {
+                if (this->thread.joinable()) {
+                    char quit = 0;
+                    while (::write(this->wakeup[1], &quit, 1) == -1 && errno == EINTR) { }
+                    this->thread.join();
+                }
+                for (int fd : this->wakeup) {
+                    if (fd >= 0) {
+                        ::close(fd);
+                    }
+                }
+                XCloseDisplay(this->display);
+            }
+
+        private:
+            void Run() {
+                pollfd fds[2];
+                fds[0].fd = ConnectionNumber(this->display);
+                fds[0].events = POLLIN;
+                fds[1].fd = this->wakeup[0];
+                fds[1].events = POLLIN;
+
+                while (true) {
+                    /* events may already be sitting in Xlib's queue, in which
+                    case the fd won't become readable for them. */
+                    bool changed = false;
+                    while (XPending(this->display)) {
+                        XEvent event;
+                        XNextEvent(this->display, &event);
+                        XRRUpdateConfiguration(&event);
+                        changed = true;
+                    }
+
+                    if (changed) {
+                        this->changed();
+                    }
+
+                    fds[0].revents = fds[1].revents = 0;
+                    if (::poll(fds, 2, -1) == -1 && errno != EINTR) {
+                        return;
+                    }
+
+                    if (fds[1].revents) {
+                        return;
+                    }
+
+                    if (fds[0].revents & (POLLERR | POLLHUP)) {
+                        return; /* lost the server */
+                    }
+                }
+            }
+
+            Display* display;
+            std::function<void()> changed;
+            std::thread thread;
+            int wakeup[2];
+    };
+
+    std::unique_ptr<RandrBackend> RandrBackend::Create() {
+        Display* display = XOpenDisplay(nullptr);
+        if (!display) {
+            return nullptr;
+        }
+
+        int eventBase, errorBase, major = 0, minor = 0;
+        if (!XRRQueryExtension(display, &eventBase, &errorBase) ||
+            !XRRQueryVersion(display, &major, &minor) ||
+            (major < 1 || (major == 1 && minor < 2)))
+        {
+            XCloseDisplay(display);
+            return nullptr;
+        }
+
+        XSetErrorHandler(ignoreErrors);
+
+        return std::unique_ptr<RandrBackend>(new RandrBackend(display));
+    }
+
+    RandrBackend::RandrBackend(Display* display)
+    : display(display) {
+        this->root = DefaultRootWindow(display);
+    }
+
+    RandrBackend::~RandrBackend() {
+        XCloseDisplay(this->display);
+    }
+
+    bool RandrBackend::ReadGamma(RRCrtc id, Crtc& crtc, Monitor& monitor) {
+        trace::Span span("x11", "XRRGetCrtcGamma");
+        XRRCrtcGamma* gamma = XRRGetCrtcGamma(this->display, id);
+        span.End();
+        if (!gamma) {
+            return false;
+        }
+
+        if (gamma->size < 2) {
+            XRRFreeGamma(gamma);
+            return false;
+        }
+
+        crtc.id = id;
+        crtc.gammaSize = gamma->size;
+
+        float value = brightnessFromRamp(gamma);
+        crtc.exponent[0] = exponentFromRamp(gamma->red, gamma->size, value);
+        crtc.exponent[1] = exponentFromRamp(gamma->green, gamma->size, value);
+        crtc.exponent[2] = exponentFromRamp(gamma->blue, gamma->size, value);
+
+        /* xrandr --verbose prints two decimal places; match it so the CLI
+        output doesn't change depending on which backend is active. */
+        monitor.brightness = std::round(value * 100.0f) / 100.0f;
+
+        for (int c = 0; c < 3; c++) {
+            monitor.gamma[c] = (float)(1.0 / crtc.exponent[c]);
+        }
+
+        XRRFreeGamma(gamma);
+        return true;
+    }
+
+    /* the same arithmetic xrandr uses to print a mode's rate */
+    static float refreshRate(XRRScreenResources* resources, RRMode id) {
+        for (int i = 0; i < resources->nmode; i++) {
+            const XRRModeInfo& mode = resources->modes[i];
+            if (mode.id == id) {
+                double vTotal = mode.vTotal;
+                if (mode.modeFlags & RR_DoubleScan) {
+                    vTotal *= 2.0;
+                }
+                if (mode.modeFlags & RR_Interlace) {
+                    vTotal /= 2.0;
+                }
+                if (mode.hTotal && vTotal > 0.0) {
+                    return (float)((double) mode.dotClock / ((double) mode.hTotal * vTotal));
+                }
+                break;
+            }
+        }
+        return 0.0f;
+    }
+
+    std::vector<Monitor> RandrBackend::Query(Probe probe) {
+        std::vector<Monitor> result;
+        this->crtcs.clear();
+        this->Visit(probe, [&result](const Monitor& monitor) {
+            result.push_back(monitor);
+            return true;
+        });
+        return result;
+    }
+
+    void RandrBackend::Visit(Probe probe, const Visitor& visit) {
+        trace::Span span("x11", "query");
+
+        trace::Span getResources("x11", (probe == Probe::Full)
+            ? "XRRGetScreenResources" : "XRRGetScreenResourcesCurrent");
+
+        XRRScreenResources* resources = (probe == Probe::Full)
+            ? XRRGetScreenResources(this->display, this->root)
+            : XRRGetScreenResourcesCurrent(this->display, this->root);
+
+        getResources.End();
+
+        if (!resources) {
+            return;
+        }
+
+        /* each output costs a few round trips; stop as soon as we're told */
+        bool more = true;
+        for (int i = 0; more && i < resources->noutput; i++) {
+            trace::Span getOutput("x11", "XRRGetOutputInfo");
+            XRROutputInfo* output = XRRGetOutputInfo(
+                this->display, resources, resources->outputs[i]);
+            getOutput.End();
+
+            if (!output) {
+                continue;
+            }
+
+            Monitor monitor;
+            monitor.name = std::string(output->name, output->nameLen);
+            monitor.connected = (output->connection == RR_Connected);
+
+            if (output->crtc != None) {
+                for (int j = 0; j < resources->ncrtc; j++) {
+                    if (resources->crtcs[j] == output->crtc) {
+                        monitor.crtc = j;
+                        break;
+                    }
+                }
+
+                trace::Span getCrtc("x11", "XRRGetCrtcInfo");
+                XRRCrtcInfo* info = XRRGetCrtcInfo(
+                    this->display, resources, output->crtc);
+                getCrtc.End();
+
+                if (info) {
+                    monitor.refresh = refreshRate(resources, info->mode);
+                    monitor.x = info->x;
+                    monitor.y = info->y;
+                    monitor.width = (int) info->width;
+                    monitor.height = (int) info->height;
+                    XRRFreeCrtcInfo(info);
+                }
+
+                Crtc crtc;
+                if (this->ReadGamma(output->crtc, crtc, monitor)) {
+                    this->crtcs[monitor.name] = crtc;
+                }
+            }
+
+            XRRFreeOutputInfo(output);
+            more = visit(monitor);
+        }
+
+        XRRFreeScreenResources(resources);
+    }
+
+    void RandrBackend::Update(const std::vector<Write>& writes) {
+        std::vector<std::pair<Crtc*, float>> ramps;
+        for (int pass = 0; pass < 2; pass++) {
+            ramps.clear();
+            for (auto& w : writes) {
+                auto it = this->crtcs.find(w.monitor.name);
+                if (it != this->crtcs.end()) {
+                    ramps.push_back({ &it->second, w.brightness });
+                }
+            }
+            if (ramps.size() == writes.size() || pass == 1) {
+                break;
+            }
+            this->Query(Probe::Current); /* an output we haven't seen yet */
+        }
+
+        /* values that quantize to the ramp that's already there wouldn't
+        change anything; common while fading slowly */
+        ramps.erase(
+            std::remove_if(ramps.begin(), ramps.end(), [](const std::pair<Crtc*, float>& r) {
+                return r.first->uploaded == GammaTable::Quantize(r.second);
+            }),
+            ramps.end());
+
+        if (ramps.empty()) {
+            return;
+        }
+
+        trace::Span span("x11", "update");
+        span.Arg("outputs", (long) ramps.size());
+
+        /* grabbing the server makes the whole batch take effect at once,
+        rather than one screen visibly changing before the next. */
+        if (ramps.size() > 1) {
+            XGrabServer(this->display);
+        }
+        for (auto& r : ramps) {
+            this->WriteGamma(*r.first, r.second);
+        }
+        if (ramps.size() > 1) {
+            XUngrabServer(this->display);
+        }
+        trace::Span flush("x11", "XFlush");
+        XFlush(this->display);
+    }
+
+    uint64_t RandrBackend::Configuration() {
+        trace::Span span("x11", "XRRGetScreenResourcesCurrent");
+        XRRScreenResources* resources = XRRGetScreenResourcesCurrent(this->display, this->root);
+        span.End();
+
+        if (!resources) {
+            return 0;
+        }
+
+        /* `timestamp` moves when a client reconfigures the screen, and
+        `configTimestamp` when the server reprobes the outputs */
+        uint64_t stamp =
+            ((uint64_t) (uint32_t) resources->configTimestamp << 32) |
+            (uint64_t) (uint32_t) resources->timestamp;
+
+        this->crtcIds.assign(resources->crtcs, resources->crtcs + resources->ncrtc);
+        XRRFreeScreenResources(resources);
+        return stamp;
+    }
+
+    bool RandrBackend::Refresh(std::vector<Monitor>& monitors) {
+        for (auto& monitor : monitors) {
+            if (monitor.crtc < 0 || monitor.crtc >= (int) this->crtcIds.size()) {
+                return false;
+            }
+            Crtc crtc;
+            if (!this->ReadGamma(this->crtcIds[monitor.crtc], crtc, monitor)) {
+                return false;
+            }
+            this->crtcs[monitor.name] = crtc;
+        }
+        return true;
+    }
+
+    void RandrBackend::WriteGamma(Crtc& crtc, float brightness) {
+        XRRCrtcGamma* gamma = XRRAllocGamma(crtc.gammaSize);
+        if (!gamma) {
+            return;
+        }
+
+        const size_t bytes = sizeof(unsigned short) * (size_t) crtc.gammaSize;
+        unsigned short* channels[] = { gamma->red, gamma->green, gamma->blue };
+        for (int c = 0; c < 3; c++) {
+            memcpy(channels[c], this->table.Ramp(crtc.gammaSize, crtc.exponent[c], brightness), bytes);
+        }
+
+        {
+            trace::Span span("x11", "XRRSetCrtcGamma");
+            XRRSetCrtcGamma(this->display, crtc.id, gamma);
+        }
+        XRRFreeGamma(gamma);
+        crtc.uploaded = GammaTable::Quantize(brightness);
+    }
+
+    std::unique_ptr<Watcher> RandrBackend::Watch(std::function<void()> changed) {
+        Display* display = XOpenDisplay(DisplayString(this->display));
+        if (!display) {
+            return nullptr;
+        }
+        return std::unique_ptr<Watcher>(new RandrWatcher(display, changed));
+    }
+}
+
+#endif
@@ -0,0 +1,89 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2019 casey langen
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the author nor the names of other contributors may
+//      be used to endorse or promote products derived from this software
+//      without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#ifdef HAVE_XRANDR
+
+#include "Backend.h"
+#include "GammaTable.h"
+
+#include <X11/Xlib.h>
+#include <X11/extensions/Xrandr.h>
+
+#include <map>
+#include <memory>
+
+namespace cmd {
+    /* talks to the X server directly via libXrandr. a single connection is
+    opened when the backend is created and held for the life of the process,
+    so reads cost a handful of X round trips and writes are a single
+    XRRSetCrtcGamma, instead of forking xrandr. */
+    class RandrBackend: public Backend {
+        public:
+            /* returns nullptr if the display can't be opened or the server
+            doesn't support RandR 1.2 (needed for per-CRTC gamma) */
+            static std::unique_ptr<RandrBackend> Create();
+
+            virtual ~RandrBackend();
+
+            virtual std::vector<Monitor> Query(Probe probe) override;
+            virtual void Visit(Probe probe, const Visitor& visit) override;
+            virtual void Update(const std::vector<Write>& writes) override;
+            virtual uint64_t Configuration() override;
+            virtual bool Refresh(std::vector<Monitor>& monitors) override;
+            virtual std::unique_ptr<Watcher> Watch(std::function<void()> changed) override;
+
+        private:
+            struct Crtc {
+                RRCrtc id;
+                int gammaSize;
+                double exponent[3]; /* r, g, b; 1.0 / xrandr's --gamma */
+                int uploaded = -1; /* GammaTable::Quantize() of what we last set */
+            };
+
+            RandrBackend(Display* display);
+
+            bool ReadGamma(RRCrtc id, Crtc& crtc, Monitor& monitor);
+            void WriteGamma(Crtc& crtc, float brightness);
+
+            Display* display;
+            Window root;
+            std::map<std::string, Crtc> crtcs;
+            std::vector<RRCrtc> crtcIds; /* as of the last Configuration() */
+            GammaTable table;
+    };
+}
+
+#endif
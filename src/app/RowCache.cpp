@@ -0,0 +1,120 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2019 casey langen
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the author nor the names of other contributors may
+//      be used to endorse or promote products derived from this software
+//      without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include "RowCache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace ui {
+    static const char THUMB[] = "■";
+    static const char TRACK[] = "─";
+    static const size_t GLYPH_BYTES = sizeof(TRACK) - 1; /* both are 3 byte utf-8 */
+    static const size_t PERCENT_WIDTH = 5; /* ' 100%' */
+
+    void RowCache::Reset(const std::vector<Monitor>& monitors) {
+        this->nameWidth = 0;
+        for (auto& m : monitors) {
+            this->nameWidth = std::max(this->nameWidth, m.name.size());
+        }
+
+        /* keeps the strings' buffers around, just not their contents */
+        this->rows.resize(monitors.size());
+        for (auto& row : this->rows) {
+            row.width = 0;
+            row.percent = row.thumb = -1;
+        }
+    }
+
+    int RowCache::Percent(const Monitor& monitor) {
+        return (int) std::round(monitor.brightness * 100.0);
+    }
+
+    bool RowCache::Format(size_t index, size_t width, const Monitor& monitor) {
+        Row& row = this->rows[index];
+
+        const int percent = Percent(monitor);
+        const int trackWidth = (int) width - ((int) PERCENT_WIDTH + (int) this->nameWidth + 3);
+        const int thumb = std::max(0, (int)(monitor.brightness * (float) trackWidth) - 1);
+
+        if (row.width == width && row.percent == percent && row.thumb == thumb) {
+            ++this->hits;
+            return false;
+        }
+
+        ++this->misses;
+        row.width = width;
+        row.percent = percent;
+        row.thumb = thumb;
+
+        const size_t name = std::min(monitor.name.size(), this->nameWidth);
+        const size_t track = (size_t) std::max(0, trackWidth);
+
+        std::string& text = row.text;
+        text.clear();
+        text.reserve(2 + this->nameWidth + track * GLYPH_BYTES + PERCENT_WIDTH);
+
+        /* " " name, right aligned, " " track, percentage right aligned */
+        text.append(1 + this->nameWidth - name, ' ');
+        text.append(monitor.name, 0, name);
+        text.push_back(' ');
+
+        /* copied out of a run of track glyphs, rather than a glyph at a time */
+        if (this->glyphs.size() < track * GLYPH_BYTES) {
+            this->glyphs.reserve(track * GLYPH_BYTES);
+            while (this->glyphs.size() < track * GLYPH_BYTES) {
+                this->glyphs.append(TRACK, GLYPH_BYTES);
+            }
+        }
+
+        if ((size_t) thumb < track) {
+            text.append(this->glyphs, 0, (size_t) thumb * GLYPH_BYTES);
+            text.append(THUMB, GLYPH_BYTES);
+            text.append(this->glyphs, 0, (track - (size_t) thumb - 1) * GLYPH_BYTES);
+        }
+        else {
+            text.append(this->glyphs, 0, track * GLYPH_BYTES);
+        }
+
+        char buffer[16];
+        int length = snprintf(buffer, sizeof(buffer), "%d%%", percent);
+        if (length > 0 && (size_t) length < PERCENT_WIDTH) {
+            text.append(PERCENT_WIDTH - (size_t) length, ' ');
+        }
+        text.append(buffer, std::max(0, length));
+
+        return true;
+    }
+}
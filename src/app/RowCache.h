@@ -0,0 +1,88 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2019 casey langen
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the author nor the names of other contributors may
+//      be used to endorse or promote products derived from this software
+//      without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "cmd.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace ui {
+    /* the text of the list's rows, e.g. "  DP-1 ───────■────────  50%", kept
+    between frames. a row is only reformatted when something it shows has
+    changed: the width, the percentage, or the thumb's position. the name
+    column's width is worked out once per Reset(), rather than per row.
+    highlighting is an attribute of the row, not part of its text, so moving
+    the selection doesn't reformat anything.
+
+    formatting writes into the row's existing string, which is sized up
+    front, so a warm cache doesn't allocate. */
+    class RowCache {
+        public:
+            /* call whenever the outputs (or their names) change; forgets
+            every row */
+            void Reset(const std::vector<Monitor>& monitors);
+
+            /* brings row `index` up to date for `monitor`; returns true if its
+            text changed (or it was never formatted) */
+            bool Format(size_t index, size_t width, const Monitor& monitor);
+
+            /* the percentage a row shows for `monitor`. brightness that
+            only differs in float error (e.g. 0.849999964 after a few of our
+            own steps, vs. the server's 0.85) shows the same. */
+            static int Percent(const Monitor& monitor);
+
+            const std::string& Text(size_t index) const {
+                return this->rows[index].text;
+            }
+
+            size_t Hits() const { return this->hits; }
+            size_t Misses() const { return this->misses; }
+
+        private:
+            struct Row {
+                std::string text;
+                size_t width = 0;
+                int percent = -1;
+                int thumb = -1;
+            };
+
+            std::vector<Row> rows;
+            std::string glyphs; /* a track, as wide as the widest one so far */
+            size_t nameWidth = 0;
+            size_t hits = 0, misses = 0;
+    };
+}
@@ -0,0 +1,226 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2019 casey langen
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the author nor the names of other contributors may
+//      be used to endorse or promote products derived from this software
+//      without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include "Transition.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <poll.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace cmd {
+    Transition::Transition(int maxFrameRate)
+    : maxFrameRate(maxFrameRate) {
+        this->timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    }
+
+    Transition::~Transition() {
+        if (this->timer >= 0) {
+            close(this->timer);
+        }
+    }
+
+    void Transition::Start(const std::vector<Write>& targets, int durationMs, Easing easing) {
+        auto now = Clock::now();
+        for (auto& target : targets) {
+            Fade fade;
+            fade.monitor = target.monitor;
+            fade.from = fade.current = target.monitor.brightness;
+            fade.to = target.brightness;
+            fade.start = now;
+            fade.duration = std::chrono::milliseconds(std::max(0, durationMs));
+            fade.easing = easing;
+
+            auto running = std::find_if(
+                this->fades.begin(),
+                this->fades.end(),
+                [&target](const Fade& f) { return f.monitor.name == target.monitor.name; });
+
+            if (running != this->fades.end()) {
+                fade.from = fade.current = running->current;
+                *running = fade;
+            }
+            else {
+                this->fades.push_back(fade);
+            }
+        }
+        this->Schedule();
+    }
+
+    void Transition::Stop(const std::string& name) {
+        auto end = std::remove_if(
+            this->fades.begin(),
+            this->fades.end(),
+            [&name](const Fade& f) { return f.monitor.name == name; });
+
+        if (end != this->fades.end()) {
+            this->fades.erase(end, this->fades.end());
+            this->Schedule();
+        }
+    }
+
+    bool Transition::Active() const {
+        return !this->fades.empty();
+    }
+
+    bool Transition::Fading(const std::string& name) const {
+        return std::any_of(
+            this->fades.begin(),
+            this->fades.end(),
+            [&name](const Fade& f) { return f.monitor.name == name; });
+    }
+
+    int Transition::Fd() const {
+        return this->timer;
+    }
+
+    int Transition::Timeout() const {
+        if (this->timer >= 0 || !this->Active()) {
+            return -1;
+        }
+        return (int) std::max(1L, this->periodNs / 1000000L);
+    }
+
+    void Transition::Wait() {
+        if (!this->Active()) {
+            return;
+        }
+
+        if (this->timer < 0) {
+            /* no timerfd to be had; sleep a frame instead */
+            timespec remaining = { this->periodNs / 1000000000L, this->periodNs % 1000000000L };
+            while (nanosleep(&remaining, &remaining) < 0 && errno == EINTR) { }
+            return;
+        }
+
+        pollfd fd = { this->timer, POLLIN, 0 };
+        while (poll(&fd, 1, -1) < 0 && errno == EINTR) { }
+    }
+
+    std::vector<Write> Transition::Frame() {
+        /* we don't care how many ticks we missed; positions are derived
+        from the clock, not from a frame count. */
+        uint64_t expirations;
+        while (this->timer >= 0 &&
+            read(this->timer, &expirations, sizeof(expirations)) < 0 && errno == EINTR) { }
+
+        std::vector<Write> result;
+        auto now = Clock::now();
+        for (auto& fade : this->fades) {
+            float t = 1.0f;
+            if (fade.duration.count() > 0) {
+                t = std::min(1.0f, std::chrono::duration<float>(now - fade.start) /
+                    std::chrono::duration<float>(fade.duration));
+            }
+            fade.current = (t >= 1.0f)
+                ? fade.to
+                : fade.from + (fade.to - fade.from) * ease(fade.easing, t);
+            result.push_back({ fade.monitor, fade.current });
+        }
+
+        auto finished = std::remove_if(
+            this->fades.begin(),
+            this->fades.end(),
+            [](const Fade& f) { return f.current == f.to; });
+
+        if (finished != this->fades.end()) {
+            this->fades.erase(finished, this->fades.end());
+            this->Schedule();
+        }
+
+        return result;
+    }
+
+    void Transition::Schedule() {
+        long periodNs = 0;
+        if (!this->fades.empty()) {
+            float hz = 0.0f;
+            for (auto& fade : this->fades) {
+                hz = std::max(hz, fade.monitor.refresh);
+            }
+            if (hz <= 0.0f) {
+                hz = (float) DEFAULT_REFRESH_HZ;
+            }
+            if (this->maxFrameRate > 0) {
+                hz = std::min(hz, (float) this->maxFrameRate);
+            }
+            hz = std::max(hz, 1.0f);
+            periodNs = (long)(1000000000.0 / hz);
+        }
+
+        if (periodNs != this->periodNs) {
+            /* tv_nsec has to stay below 1s; at 1Hz the period is exactly that */
+            itimerspec spec = { };
+            spec.it_interval.tv_sec = periodNs / 1000000000L;
+            spec.it_interval.tv_nsec = periodNs % 1000000000L;
+            spec.it_value = spec.it_interval;
+            if (this->timer >= 0) {
+                timerfd_settime(this->timer, 0, &spec, nullptr);
+            }
+            this->periodNs = periodNs;
+        }
+    }
+
+    float ease(Easing easing, float t) {
+        switch (easing) {
+            case Easing::In:
+                return t * t * t;
+            case Easing::Out: {
+                float u = 1.0f - t;
+                return 1.0f - u * u * u;
+            }
+            case Easing::InOut: {
+                if (t < 0.5f) {
+                    return 4.0f * t * t * t;
+                }
+                float u = -2.0f * t + 2.0f;
+                return 1.0f - u * u * u / 2.0f;
+            }
+            default:
+                return t;
+        }
+    }
+
+    bool parseEasing(const std::string& name, Easing& easing) {
+        if (name == "linear") { easing = Easing::Linear; }
+        else if (name == "in") { easing = Easing::In; }
+        else if (name == "out") { easing = Easing::Out; }
+        else if (name == "in-out") { easing = Easing::InOut; }
+        else { return false; }
+        return true;
+    }
+}
@@ -0,0 +1,117 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2019 casey langen
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the author nor the names of other contributors may
+//      be used to endorse or promote products derived from this software
+//      without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "cmd.h"
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace cmd {
+    /* moves the brightness of one or more outputs towards a target over
+    time, paced by a timerfd that ticks once per refresh of the fastest
+    output involved (60Hz if the backend couldn't tell us).
+
+    it never touches the backend itself; the owner waits for Fd() to become
+    readable (or calls Wait()), then applies Frame() as a single
+    cmd::update() batch, i.e. one gamma upload per output per frame.
+
+        transition.Start(targets, 250, Easing::InOut);
+        while (transition.Active()) {
+            transition.Wait();
+            cmd::update(transition.Frame());
+        } */
+    class Transition {
+        public:
+            static const int DEFAULT_REFRESH_HZ = 60;
+
+            /* `maxFrameRate` caps the tick rate; 0 for no cap. see
+            cmd::maxFrameRate(). */
+            Transition(int maxFrameRate = 0);
+            ~Transition();
+
+            /* fades each target from its monitor's brightness to its
+            brightness, both of which should already be clamped. if an
+            output is already fading, it continues from wherever it got to. */
+            void Start(const std::vector<Write>& targets, int durationMs, Easing easing);
+
+            /* abandons the output's fade where it is, e.g. because it was
+            just written directly */
+            void Stop(const std::string& name);
+
+            bool Active() const;
+            bool Fading(const std::string& name) const;
+
+            /* -1 if no timerfd could be created, in which case owners that
+            poll it should use Timeout() instead, and call Frame() when it
+            runs out */
+            int Fd() const;
+
+            /* ms until the next frame if there's no Fd() to poll; -1 if
+            there is one, or nothing is fading */
+            int Timeout() const;
+
+            void Wait();
+
+            /* the values for right now; finished fades produce their target
+            value one last time, and are then dropped. */
+            std::vector<Write> Frame();
+
+        private:
+            using Clock = std::chrono::steady_clock;
+
+            struct Fade {
+                Monitor monitor;
+                float from, to, current;
+                Clock::time_point start;
+                Clock::duration duration;
+                Easing easing;
+            };
+
+            void Schedule();
+
+            std::vector<Fade> fades;
+            int timer = -1;
+            int maxFrameRate;
+            long periodNs = 0; /* 0 while disarmed */
+    };
+
+    /* maps linear progress in [0, 1] onto the curve */
+    float ease(Easing easing, float t);
+
+    /* "linear", "in", "out" or "in-out" */
+    bool parseEasing(const std::string& name, Easing& easing);
+}
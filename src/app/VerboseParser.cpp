@@ -0,0 +1,201 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2019 casey langen
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the author nor the names of other contributors may
+//      be used to endorse or promote products derived from this software
+//      without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include "VerboseParser.h"
+#include "str.h"
+
+namespace cmd {
+    /* "1920x1080+0+0" */
+    static bool parseGeometry(const str::view& token, Monitor& monitor) {
+        static const char SEPARATORS[] = "x++";
+        int values[4];
+        const char* p = token.begin();
+        for (int i = 0; i < 4; i++) {
+            if (i > 0) {
+                if (p == token.end() || *p != SEPARATORS[i - 1]) {
+                    return false;
+                }
+                ++p;
+            }
+            const char* next = str::fromChars(p, token.end(), values[i]);
+            if (next == p) {
+                return false;
+            }
+            p = next;
+        }
+        if (p != token.end()) {
+            return false;
+        }
+        monitor.width = values[0];
+        monitor.height = values[1];
+        monitor.x = values[2];
+        monitor.y = values[3];
+        return true;
+    }
+
+    VerboseParser::VerboseParser(Visitor visit) : visit(visit) {
+    }
+
+    void VerboseParser::Feed(const str::view& line) {
+        /* most of the output is EDID hex dumps, mode timings and output
+        properties we don't care about; decide from the first couple of
+        characters which lines are worth tokenizing. */
+        if (line.empty() || this->done) {
+            return;
+        }
+        else if (line[0] == '\t') {
+            /* two or more tabs are continuation lines (EDID hex dumps,
+            transform matrix rows, property values); we don't need them */
+            if (line.size() > 1 && line[1] != '\t' && line[1] != ' ') {
+                this->ParseProperty(line);
+            }
+        }
+        else if (line[0] == ' ') {
+            /* "  1920x1080 (0x47) 138.700MHz +HSync -VSync *current +preferred"
+            is followed by its "h:" and "v:" timing lines, indented further;
+            the v: line of the active mode has the refresh rate. */
+            if (line.size() > 2 && line[2] != ' ') {
+                this->currentMode = line.find("*current") != str::view::npos;
+            }
+            else if (this->currentMode) {
+                this->ParseTiming(line);
+            }
+        }
+        else if (!line.startsWith("Screen ")) {
+            this->currentMode = false;
+            this->ParseHeader(line);
+        }
+    }
+
+    void VerboseParser::Finish() {
+        this->Visit();
+    }
+
+    bool VerboseParser::Done() const {
+        return this->done;
+    }
+
+    void VerboseParser::Visit() {
+        if (this->visit && !this->visited && !this->done && !this->monitors.empty()) {
+            this->visited = true;
+            this->done = !this->visit(this->monitors.back());
+        }
+    }
+
+    const std::vector<Monitor>& VerboseParser::Monitors() const {
+        return this->monitors;
+    }
+
+    /* "eDP-1 connected primary 1920x1080+0+0 (0x47) normal (normal ...) 344mm x 193mm"
+       "HDMI-1 disconnected (normal left inverted right x axis y axis)" */
+    void VerboseParser::ParseHeader(const str::view& line) {
+        str::tokenizer parts(line, " ");
+        str::view name, state;
+        if (!parts.next(name) || !parts.next(state)) {
+            return;
+        }
+
+        this->Visit(); /* in case it had no CRTCs line */
+        if (this->done) {
+            return;
+        }
+
+        Monitor monitor;
+        monitor.name = name.str();
+        monitor.connected = (state == "connected");
+
+        for (str::view part; parts.next(part) && part[0] != '(';) {
+            if (parseGeometry(part, monitor)) {
+                break;
+            }
+        }
+
+        this->monitors.push_back(std::move(monitor));
+        this->visited = false;
+    }
+
+    /* "        v: height 1080 start 1083 end 1088 total 1111           clock  59.96Hz" */
+    void VerboseParser::ParseTiming(const str::view& line) {
+        auto timing = line.trim();
+        if (this->monitors.empty() || !timing.startsWith("v:")) {
+            return;
+        }
+        auto clock = timing.find("clock");
+        if (clock != str::view::npos) {
+            auto value = timing.substr(clock + 5).trim();
+            str::fromChars(value.begin(), value.end(), this->monitors.back().refresh);
+        }
+        this->currentMode = false;
+    }
+
+    void VerboseParser::ParseProperty(const str::view& line) {
+        if (this->monitors.empty()) {
+            return;
+        }
+
+        auto& monitor = this->monitors.back();
+        auto colon = line.find(':');
+        if (colon == str::view::npos) {
+            return;
+        }
+
+        auto key = line.substr(0, colon).trim();
+        auto value = line.substr(colon + 1).trim();
+
+        if (key == "CRTC") {
+            str::fromChars(value.begin(), value.end(), monitor.crtc);
+        }
+        else if (key == "Brightness") {
+            str::fromChars(value.begin(), value.end(), monitor.brightness);
+        }
+        else if (key == "Gamma") {
+            /* "1.0:1.0:1.0" */
+            str::tokenizer channels(value, ":");
+            float gamma[3];
+            size_t count = 0;
+            for (str::view channel; channels.next(channel); count++) {
+                if (count < 3 && !str::parse(channel, gamma[count])) {
+                    return;
+                }
+            }
+            if (count == 3) {
+                std::copy(gamma, gamma + 3, monitor.gamma);
+            }
+        }
+        else if (key == "CRTCs") {
+            /* every output has one, right after the properties we use */
+            this->Visit();
+        }
+    }
+}
@@ -0,0 +1,80 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2019 casey langen
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the author nor the names of other contributors may
+//      be used to endorse or promote products derived from this software
+//      without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "cmd.h"
+#include "str.h"
+
+#include <functional>
+
+namespace cmd {
+    /* incrementally parses the output of `xrandr --verbose`, one line at a
+    time, into a Monitor record per output. everything we need comes from a
+    single invocation, and values are attached to the output they were
+    printed under instead of being lined up by position. lines are
+    tokenized in place; the only allocations are the output names and the
+    list itself. */
+    class VerboseParser {
+        public:
+            using Visitor = std::function<bool(const Monitor&)>;
+
+            /* if given, `visit` is called with each output as soon as
+            everything up to its CRTC is known, i.e. before its EDID, other
+            properties and modes; the refresh rate is missing at that point.
+            once it returns false, Done() is true and further input is
+            ignored. */
+            VerboseParser(Visitor visit = Visitor());
+
+            void Feed(const str::view& line);
+
+            /* the input is over; visits the last output, if need be */
+            void Finish();
+            bool Done() const;
+
+            const std::vector<Monitor>& Monitors() const;
+
+        private:
+            void ParseHeader(const str::view& line);
+            void ParseProperty(const str::view& line);
+            void ParseTiming(const str::view& line);
+            void Visit();
+
+            std::vector<Monitor> monitors;
+            bool currentMode = false; /* the last mode line was the active one */
+            Visitor visit;
+            bool visited = false; /* monitors.back() has been visited */
+            bool done = false;
+    };
+}
@@ -0,0 +1,261 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2019 casey langen
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the author nor the names of other contributors may
+//      be used to endorse or promote products derived from this software
+//      without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include "cli.h"
+#include "cxxopts.hpp"
+#include "Daemon.h"
+#include "ipc.h"
+#include "str.h"
+#include "trace.h"
+#include "Transition.h"
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/* prints a daemon's error response, if `response` is one; see ipc.h */
+static bool remoteFailed(const std::string& response) {
+    if (response.empty() || response[0] != '+') {
+        std::cerr << (response.empty() ? response : response.substr(1)) << "\n";
+        return true;
+    }
+    return false;
+}
+
+/* the output may be incomplete, or the brightness unchanged */
+static void reportTimeout() {
+    if (cmd::Deadline::Expired()) {
+        std::cerr << "timed out waiting for xrandr\n";
+    }
+}
+
+bool handleCommandLine(int argc, char* argv[], Settings& settings) {
+    cxxopts::Options options("xdimmer", "");
+
+    options
+        .add_options("all")
+        ("list", "List all device names")
+        ("get", "Get the brightness for the specified device")
+        ("set", "Set the brightness for the specified device")
+        ("delta", "Apply a brightness delta to the specified device", cxxopts::value<std::string>())
+        ("device", "Device name or index; for --get and --set, a comma separated list or \"all\"", cxxopts::value<std::string>())
+        ("value", "Brightness value", cxxopts::value<float>())
+        ("rescan", "Make the X server reprobe all outputs (slow) and report probe times")
+        ("daemon", "Serve --list, --get and --set for other xdimmer processes; see ipc.h")
+        ("fade-ms", "Fade to the new brightness over this many milliseconds (--set, and the ui's all-output keys)", cxxopts::value<int>())
+        ("easing", "Fade curve: linear, in, out or in-out", cxxopts::value<std::string>())
+        ("write-interval", "Minimum milliseconds between brightness writes to an output in the UI", cxxopts::value<int>())
+        ("timeout-ms", "Give up on a --list, --get or --set that takes longer than this; 0 waits for as long as it takes", cxxopts::value<int>())
+        ("poll-max-ms", "Longest the UI goes without checking for outside changes, when the server can't notify it", cxxopts::value<int>())
+        ("trace", "Record timings to this file, in Chrome trace format; \"debug\" sends them to the ui's debug log instead", cxxopts::value<std::string>())
+        ("help", "Display help");
+
+    auto result = options.parse(argc, argv);
+
+    /* if a daemon is running, --list, --get and --set are forwarded to it,
+    which saves us probing the outputs ourselves. */
+    ipc::Client daemon;
+    std::string response;
+
+    /* first, so everything after this point is covered */
+    if (result.count("trace")) {
+        std::string path = result["trace"].as<std::string>();
+        if (path == "debug") {
+            settings.traceToDebug = true;
+        }
+        else if (!trace::open(path)) {
+            std::cerr << "could not open trace file '" << path << "'\n";
+            exit(0);
+        }
+    }
+
+    if (result.count("write-interval")) {
+        settings.writeIntervalMs = result["write-interval"].as<int>();
+    }
+
+    if (result.count("poll-max-ms")) {
+        settings.pollMaxMs = result["poll-max-ms"].as<int>();
+    }
+
+    /* the cli doesn't fade unless asked to */
+    int fadeMs = 0;
+    if (result.count("fade-ms")) {
+        settings.fadeMs = fadeMs = std::max(0, result["fade-ms"].as<int>());
+    }
+
+    std::string easing = result.count("easing") ? result["easing"].as<std::string>() : "in-out";
+    if (!cmd::parseEasing(easing, settings.easing)) {
+        std::cerr << "invalid easing '" << easing << "' specified\n";
+        exit(0);
+    }
+
+    /* sent to the daemon along with --set; see ipc.h */
+    std::string fadeArgs = fadeMs ? " " + std::to_string(fadeMs) + " " + easing : "";
+
+    if (result.count("daemon")) {
+        ipc::Daemon server;
+        if (server.Listen()) {
+            server.Run();
+        }
+        return true;
+    }
+
+    if (result.count("rescan")) {
+        cmd::query();
+        cmd::rescan();
+        auto& current = cmd::stats(cmd::Probe::Current);
+        auto& full = cmd::stats(cmd::Probe::Full);
+        std::cerr << "cached probe: " << current.lastMs << "ms\n";
+        std::cerr << "full probe: " << full.lastMs << "ms\n";
+        if (!result.count("list") && !result.count("get") && !result.count("set")) {
+            return true;
+        }
+    }
+
+    /* a hung server shouldn't hang scripts (or key bindings) with it. a fade
+    gets its length on top. */
+    int timeoutMs = result.count("timeout-ms")
+        ? result["timeout-ms"].as<int>() : cmd::Deadline::DEFAULT_MS;
+    cmd::Deadline deadline(timeoutMs > 0 ? timeoutMs + fadeMs : 0);
+
+    /* we're gone again in a moment; see cmd::useDeviceCache(). the ui (when
+    we return false) is long-lived, and leaves it off. */
+    if (result.count("list") || result.count("get") || result.count("set")) {
+        cmd::useDeviceCache(true);
+    }
+
+    if (result.count("list")) {
+        if (daemon.Call("l", response)) {
+            if (!remoteFailed(response)) {
+                int i = 0;
+                for (auto& d : str::split(response.substr(1), " ")) {
+                    auto equals = d.rfind('=');
+                    std::cout << "[" << i++ << "] " << d.substr(0, equals) << ": " << d.substr(equals + 1) << "\n";
+                }
+            }
+            return true;
+        }
+        auto devices = cmd::query();
+        int i = 0;
+        for (auto d: devices) {
+            std::cout << "[" << i++ << "] " << d.name << ": " << d.brightness << "\n";
+        }
+        reportTimeout();
+        return true;
+    }
+    else if (result.count("get")) {
+        if (!result.count("device")) {
+            goto printhelp;
+        }
+        std::string device = result["device"].as<std::string>();
+        if (daemon.Call("g " + device, response)) {
+            if (!remoteFailed(response)) {
+                std::cout << response.substr(1);
+            }
+            return true;
+        }
+        /* every match, like the daemon's `g` */
+        auto found = cmd::resolve(device);
+        if (found.empty()) {
+            std::cerr << (cmd::Deadline::Expired() ? "timed out looking for device=" : "could not find device=");
+            std::cerr << device << "\n";
+            return true;
+        }
+        for (size_t i = 0; i < found.size(); i++) {
+            std::cout << (i ? " " : "") << str::fmt("%g", found[i].brightness);
+        }
+        reportTimeout();
+        return true;
+    }
+    else if (result.count("set")) {
+        if (!result.count("device") || 
+            (!result.count("value") && !result.count("delta")))
+        {
+            goto printhelp;
+        }
+        else if (result.count("value")) {
+            float value = result["value"].as<float>();
+            std::string device = result["device"].as<std::string>();
+            if (daemon.Call("s " + device + " " + str::fmt("%f", value) + fadeArgs, response)) {
+                remoteFailed(response);
+                return true;
+            }
+            if (fadeMs) {
+                std::vector<cmd::Write> writes;
+                for (auto& m : cmd::resolve(device)) {
+                    writes.push_back({ m, value });
+                }
+                cmd::fade(writes, fadeMs, settings.easing);
+            }
+            else {
+                cmd::update(device, value);
+            }
+        }
+        else if (result.count("delta")) {
+            std::string delta = result["delta"].as<std::string>();
+            std::string devices = result["device"].as<std::string>();
+            float d;
+            if (!str::parse(delta, d)) {
+                std::cerr << "invalid delta '" << delta << "' specified\n";
+                exit(0);
+            }
+            if (daemon.Call("d " + devices + " " + str::fmt("%f", d) + fadeArgs, response)) {
+                remoteFailed(response);
+                return true;
+            }
+            std::vector<cmd::Write> writes;
+            for (auto& m : cmd::resolve(devices)) {
+                writes.push_back({ m, m.brightness + d });
+            }
+            if (fadeMs) {
+                cmd::fade(writes, fadeMs, settings.easing);
+            }
+            else {
+                cmd::update(writes);
+            }
+        }
+        reportTimeout();
+        return true;
+    }
+    else if (result.count("help")) {
+        goto printhelp;
+    }
+
+    return false;
+
+printhelp:
+    std::cout << options.help({"", "all"}) << std::endl;
+    exit(0);
+}
@@ -0,0 +1,59 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2019 casey langen
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the author nor the names of other contributors may
+//      be used to endorse or promote products derived from this software
+//      without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "cmd.h"
+
+/* the ui's defaults; the command line can override them */
+static const int DEFAULT_FADE_MS = 150;
+static const int DEFAULT_WRITE_INTERVAL_MS = 33;
+static const int DEFAULT_POLL_MAX_MS = 10000;
+
+/* what the command line asks of the ui, should it run */
+struct Settings {
+    int writeIntervalMs = DEFAULT_WRITE_INTERVAL_MS;
+    int fadeMs = DEFAULT_FADE_MS; /* for the large, all-output steps in the ui */
+    cmd::Easing easing = cmd::Easing::InOut;
+    int pollMaxMs = DEFAULT_POLL_MAX_MS; /* without change notifications */
+    bool traceToDebug = false; /* --trace debug; see main() */
+};
+
+/* carries out --list, --get, --set, --rescan and --daemon, and fills in
+`settings` from the rest. returns false if there was nothing to do, i.e. the
+ui should run. exits on invalid arguments.
+
+nothing here touches curses or f8n, so it can be linked on its own; see the
+xdimmer-cli target. */
+bool handleCommandLine(int argc, char* argv[], Settings& settings);
@@ -0,0 +1,370 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2019 casey langen
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the author nor the names of other contributors may
+//      be used to endorse or promote products derived from this software
+//      without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include "cmd.h"
+#include "str.h"
+#include "DeviceCache.h"
+#include "ProcessBackend.h"
+#include "RandrBackend.h"
+#include "Transition.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <memory>
+
+namespace cmd {
+    static std::unique_ptr<Backend> createBackend() {
+        std::unique_ptr<Backend> result;
+#ifdef HAVE_XRANDR
+        result = RandrBackend::Create();
+#endif
+        if (!result) {
+            result.reset(new ProcessBackend());
+        }
+        return result;
+    }
+
+    static Backend& backend() {
+        static std::unique_ptr<Backend> instance = createBackend();
+        return *instance;
+    }
+
+    static thread_local Deadline::Clock::time_point deadline = Deadline::Clock::time_point::max();
+    static thread_local bool expired = false;
+
+    Deadline::Deadline(int ms)
+    : previous(deadline), previousExpired(expired) {
+        if (ms > 0) {
+            deadline = std::min(deadline, Clock::now() + std::chrono::milliseconds(ms));
+        }
+        expired = false;
+    }
+
+    Deadline::~Deadline() {
+        deadline = this->previous;
+        expired = this->previousExpired || expired;
+    }
+
+    Deadline::Clock::time_point Deadline::Current() {
+        return deadline;
+    }
+
+    bool Deadline::Expired() {
+        return expired;
+    }
+
+    void Deadline::Expire() {
+        expired = true;
+    }
+
+    static ProbeStats currentStats, fullStats;
+
+    /* the brightness each output was last seen at, or set to, by us. lets
+    update() skip writes that wouldn't change anything. */
+    static std::map<std::string, float> known;
+
+    static std::vector<Monitor> probe(Probe type) {
+        using namespace std::chrono;
+        auto start = steady_clock::now();
+        /* before the query, so a change during it makes refresh() refuse */
+        uint64_t stamp = backend().Configuration();
+        auto all = backend().Query(type);
+        auto& stats = (type == Probe::Full) ? fullStats : currentStats;
+        stats.lastMs = duration<double, std::milli>(steady_clock::now() - start).count();
+        stats.totalMs += stats.lastMs;
+        ++stats.count;
+
+        std::vector<Monitor> result;
+        known.clear();
+        for (auto& m : all) {
+            if (m.connected && m.crtc >= 0) {
+                known[m.name] = m.brightness;
+                result.push_back(m);
+                result.back().configuration = stamp;
+            }
+        }
+        return result;
+    }
+
+    static bool useCache = false;
+
+    void useDeviceCache(bool use) {
+        useCache = use;
+    }
+
+    /* query(), from the cache if it's still valid, and into it if not.
+    returns false if the cache can't be used at all. */
+    static bool cachedQuery(std::vector<Monitor>& result) {
+        if (!useCache) {
+            return false;
+        }
+
+        uint64_t stamp = backend().Configuration();
+        if (!stamp) {
+            return false;
+        }
+
+        DeviceCache cache;
+        if (cache.Load(stamp, result) && backend().Refresh(result)) {
+            known.clear();
+            for (auto& m : result) {
+                known[m.name] = m.brightness;
+                m.configuration = stamp;
+            }
+            return true;
+        }
+
+        result = probe(Probe::Current);
+        if (!Deadline::Expired()) {
+            cache.Store(stamp, result);
+        }
+        return true;
+    }
+
+    std::vector<Monitor> query() {
+        std::vector<Monitor> result;
+        if (cachedQuery(result)) {
+            return result;
+        }
+        return probe(Probe::Current);
+    }
+
+    std::vector<Monitor> rescan() {
+        return probe(Probe::Full);
+    }
+
+    bool refresh(std::vector<Monitor>& monitors) {
+        /* Refresh() maps crtc indexes onto the CRTC list as of right now,
+        which is only safe if it's the one they came from */
+        uint64_t stamp = backend().Configuration();
+        if (!stamp) {
+            return false;
+        }
+        for (auto& m : monitors) {
+            if (m.configuration != stamp) {
+                return false;
+            }
+        }
+        if (!backend().Refresh(monitors)) {
+            return false;
+        }
+        for (auto& m : monitors) {
+            known[m.name] = m.brightness;
+        }
+        return true;
+    }
+
+    const ProbeStats& stats(Probe type) {
+        return (type == Probe::Full) ? fullStats : currentStats;
+    }
+
+    float query(const std::string& device) {
+        auto found = resolve(device);
+        if (found.empty()) {
+            std::cerr << (Deadline::Expired() ? "timed out looking for device=" : "could not find device=");
+            std::cerr << device << "\n";
+            exit(0);
+        }
+        return found[0].brightness;
+    }
+
+    float clamp(float brightness) {
+        if (brightness < 0.05) { brightness = 0.05; }
+        if (brightness > 1.0) { brightness = 1.0; }
+        return brightness;
+    }
+
+    std::vector<Monitor> resolve(const std::string& devices) {
+        if (devices == "all") {
+            return query();
+        }
+
+        std::vector<Monitor> all;
+        if (cachedQuery(all)) {
+            return resolve(all, devices);
+        }
+
+        std::vector<str::view> wanted;
+        str::tokenizer tokens(devices, ",");
+        for (str::view device; tokens.next(device);) {
+            wanted.push_back(device);
+        }
+
+        /* streamed, so the probe can stop at the last output we're after,
+        rather than listing everything first. an index counts the same
+        outputs query() would return. */
+        std::vector<Monitor> found(wanted.size());
+        std::vector<bool> matched(wanted.size(), false);
+        size_t remaining = wanted.size();
+        int position = 0;
+
+        if (remaining > 0) {
+            backend().Visit(Probe::Current, [&](const Monitor& m) {
+                if (!m.connected || m.crtc < 0) {
+                    return true;
+                }
+                known[m.name] = m.brightness;
+                for (size_t i = 0; i < wanted.size(); i++) {
+                    if (!matched[i] && (wanted[i] == m.name || str::parseIndex(wanted[i]) == position)) {
+                        found[i] = m;
+                        matched[i] = true;
+                        --remaining;
+                    }
+                }
+                ++position;
+                return remaining > 0;
+            });
+        }
+
+        std::vector<Monitor> result;
+        for (size_t i = 0; i < wanted.size(); i++) {
+            if (matched[i]) {
+                result.push_back(found[i]);
+            }
+        }
+        return result;
+    }
+
+    std::vector<Monitor> resolve(const std::vector<Monitor>& all, const std::string& devices) {
+        if (devices == "all") {
+            return all;
+        }
+        std::vector<Monitor> result;
+        str::tokenizer tokens(devices, ",");
+        for (str::view device; tokens.next(device);) {
+            bool found = false;
+            for (auto& d : all) {
+                if (device == d.name) {
+                    result.push_back(d);
+                    found = true;
+                    break;
+                }
+            }
+            int index = str::parseIndex(device);
+            if (!found && index >= 0 && all.size() > index) {
+                result.push_back(all[index]);
+            }
+        }
+        return result;
+    }
+
+    void update(const Monitor& monitor, float brightness) {
+        update(std::vector<Write>{ { monitor, brightness } });
+    }
+
+    void update(const std::string& devices, float brightness) {
+        std::vector<Write> writes;
+        for (auto& m : resolve(devices)) {
+            writes.push_back({ m, brightness });
+        }
+        update(writes);
+    }
+
+    void update(const std::vector<Write>& writes) {
+        std::vector<Write> batch;
+        for (auto& w : writes) {
+            float brightness = clamp(w.brightness);
+
+            auto last = known.find(w.monitor.name);
+            if (last != known.end() && std::fabs(last->second - brightness) < 0.0005f) {
+                continue;
+            }
+
+            auto same = std::find_if(batch.begin(), batch.end(), [&w](const Write& b) {
+                return w.monitor.crtc >= 0 && b.monitor.crtc == w.monitor.crtc;
+            });
+
+            if (same != batch.end()) {
+                same->brightness = brightness;
+            }
+            else {
+                batch.push_back({ w.monitor, brightness });
+            }
+        }
+
+        if (batch.empty()) {
+            return;
+        }
+
+        backend().Update(batch);
+
+        if (Deadline::Expired()) {
+            /* no telling which writes stuck, so don't skip any next time */
+            for (auto& w : writes) {
+                known.erase(w.monitor.name);
+            }
+            return;
+        }
+
+        /* mirrors follow their CRTC, whether or not they were written */
+        for (auto& w : writes) {
+            for (auto& b : batch) {
+                if (b.monitor.name == w.monitor.name ||
+                    (b.monitor.crtc >= 0 && b.monitor.crtc == w.monitor.crtc))
+                {
+                    known[w.monitor.name] = b.brightness;
+                }
+            }
+        }
+    }
+
+    void fade(const std::vector<Write>& targets, int durationMs, Easing easing) {
+        std::vector<Write> clamped;
+        for (auto& t : targets) {
+            clamped.push_back({ t.monitor, clamp(t.brightness) });
+        }
+
+        Transition transition(maxFrameRate());
+        transition.Start(clamped, durationMs, easing);
+        while (transition.Active()) {
+            transition.Wait();
+            update(transition.Frame());
+        }
+    }
+
+    int maxFrameRate() {
+        return backend().MaxFrameRate();
+    }
+
+    void cancel() {
+        backend().Cancel();
+    }
+
+    std::unique_ptr<Watcher> watch(std::function<void()> changed) {
+        return backend().Watch(changed);
+    }
+}
@@ -0,0 +1,179 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2019 casey langen
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the author nor the names of other contributors may
+//      be used to endorse or promote products derived from this software
+//      without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct Monitor {
+    std::string name;
+    float brightness = 1.0f;
+    bool connected = true;
+    int crtc = -1; /* index into the screen's CRTC list; -1 if the output is off */
+    int x = 0, y = 0, width = 0, height = 0;
+    float gamma[3] = { 1.0f, 1.0f, 1.0f }; /* r, g, b; same scale as `xrandr --gamma` */
+    float refresh = 0.0f; /* Hz of the current mode; 0 if unknown */
+    uint64_t configuration = 0; /* Backend::Configuration() when queried; 0 if unknown */
+};
+
+namespace cmd {
+    enum class Probe {
+        Current, /* whatever the server already knows; cheap */
+        Full     /* server re-detects every output, reading EDIDs over DDC; slow */
+    };
+
+    enum class Easing {
+        Linear,
+        In,   /* starts slow */
+        Out,  /* ends slow */
+        InOut
+    };
+
+    struct ProbeStats {
+        size_t count = 0;
+        double totalMs = 0.0;
+        double lastMs = 0.0;
+    };
+
+    struct Write {
+        Monitor monitor;
+        float brightness;
+    };
+
+    /* returned by watch(); the callback stops firing once it's destroyed. */
+    class Watcher {
+        public:
+            virtual ~Watcher() {
+            }
+    };
+
+    /* bounds how long the backend calls this thread makes may take, for as
+    long as it exists; if the server hangs (a GPU reset, a stuck DDC probe)
+    they'd otherwise block indefinitely. a call that runs out of time kills
+    its xrandr process and returns what it had by then: queries come back
+    short, and writes may or may not have happened. Expired() then returns
+    true. deadlines nest, and the earliest one applies.
+
+    only the process backend can honor them; Xlib has no timeouts. */
+    class Deadline {
+        public:
+            using Clock = std::chrono::steady_clock;
+
+            static const int DEFAULT_MS = 3000;
+            static const int RESCAN_MS = 15000; /* reprobing is slow anyway */
+
+            /* `ms` <= 0 adds no deadline of its own */
+            explicit Deadline(int ms);
+            ~Deadline();
+
+            /* the deadline for this thread; Clock::time_point::max() if none */
+            static Clock::time_point Current();
+
+            /* whether a call ran out of time since the innermost Deadline
+            on this thread was created */
+            static bool Expired();
+
+            /* for backends */
+            static void Expire();
+
+        private:
+            Clock::time_point previous;
+            bool previousExpired;
+    };
+
+    /* lets query() and resolve() answer from DeviceCache for as long as the
+    backend says the configuration is unchanged, re-reading only brightness.
+    for short-lived processes; long-lived ones query as they need to, and
+    don't touch the cache. off by default. */
+    void useDeviceCache(bool use);
+
+    /* connected outputs that are driven by a CRTC, i.e. the ones whose
+    brightness can actually be adjusted. never makes the server reprobe
+    outputs; see rescan(). */
+    std::vector<Monitor> query();
+    float query(const std::string& device);
+
+    /* re-reads the brightness of `monitors`, as returned by an earlier
+    query(), in place and without listing the outputs again; one round trip
+    per output. false if the backend can't, or the configuration has changed
+    since they were queried, in which case query() again. */
+    bool refresh(std::vector<Monitor>& monitors);
+
+    /* `devices` is "all", or a comma separated list of names and/or indexes
+    into query(). unknown entries are skipped. */
+    std::vector<Monitor> resolve(const std::string& devices);
+    std::vector<Monitor> resolve(const std::vector<Monitor>& all, const std::string& devices);
+
+    /* brightness values are limited to [0.05, 1.0]; any lower and the
+    screen is effectively off, which is hard to recover from. */
+    float clamp(float brightness);
+
+    void update(const Monitor& monitor, float brightness);
+    void update(const std::string& devices, float brightness);
+
+    /* applies all writes as a single backend operation. outputs that share
+    a CRTC (i.e. mirrors) are only written once, the last write winning, and
+    outputs that are already at the requested brightness are skipped. */
+    void update(const std::vector<Write>& writes);
+
+    /* blocks while the outputs fade from their current brightness to the
+    target, one write per frame; see Transition. */
+    void fade(const std::vector<Write>& targets, int durationMs, Easing easing);
+
+    /* the most writes per second a fade should make with the active
+    backend; 0 if there's no particular limit. */
+    int maxFrameRate();
+
+    /* like query(), but makes the server reprobe all outputs first. this can
+    take hundreds of milliseconds (e.g. on docking stations), so it should
+    only ever be done in response to an explicit user request. */
+    std::vector<Monitor> rescan();
+
+    const ProbeStats& stats(Probe probe);
+
+    /* aborts an in-flight query, if the backend is able to; the query then
+    returns early with incomplete results. may be called from any thread. */
+    void cancel();
+
+    /* invokes `changed` from a background thread whenever the server reports
+    an output, CRTC or screen configuration change. returns nullptr if the
+    active backend can't deliver notifications, in which case callers need
+    to poll. */
+    std::unique_ptr<Watcher> watch(std::function<void()> changed);
+}
@@ -0,0 +1,182 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2019 casey langen
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the author nor the names of other contributors may
+//      be used to endorse or promote products derived from this software
+//      without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include "ipc.h"
+#include "cmd.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace ipc {
+    std::string path() {
+        const char* dir = getenv("XDG_RUNTIME_DIR");
+        if (dir && *dir) {
+            return std::string(dir) + "/xdimmer.sock";
+        }
+        return "/tmp/xdimmer-" + std::to_string(getuid()) + ".sock";
+    }
+
+    Client::~Client() {
+        if (this->fd >= 0) {
+            close(this->fd);
+        }
+    }
+
+    bool Client::Connect() {
+        if (this->fd >= 0) {
+            return true;
+        }
+
+        std::string socketPath = path();
+        sockaddr_un address = { };
+        if (socketPath.size() >= sizeof(address.sun_path)) {
+            return false;
+        }
+        address.sun_family = AF_UNIX;
+        strcpy(address.sun_path, socketPath.c_str());
+
+        /* non-blocking, so a stuck daemon can't hold us past the deadline;
+        a full backlog fails the connect rather than waiting */
+        this->fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+        if (this->fd < 0) {
+            return false;
+        }
+
+        if (connect(this->fd, (sockaddr*) &address, sizeof(address)) != 0) {
+            close(this->fd);
+            this->fd = -1;
+            return false;
+        }
+
+        return true;
+    }
+
+    void Client::Queue(const std::string& request) {
+        this->out += request;
+        this->out += '\n';
+    }
+
+    bool Client::Flush() {
+        size_t offset = 0;
+        while (offset < this->out.size()) {
+            ssize_t count = send(
+                this->fd,
+                this->out.data() + offset,
+                this->out.size() - offset,
+                MSG_NOSIGNAL);
+
+            if (count < 0) {
+                if (errno == EINTR || ((errno == EAGAIN || errno == EWOULDBLOCK) && this->Wait(POLLOUT))) {
+                    continue;
+                }
+                return false;
+            }
+            offset += (size_t) count;
+        }
+        this->out.clear();
+        return true;
+    }
+
+    bool Client::Receive(std::string& response) {
+        while (true) {
+            size_t end = this->in.find('\n');
+            if (end != std::string::npos) {
+                response.assign(this->in, 0, end);
+                this->in.erase(0, end + 1);
+                return true;
+            }
+
+            char buffer[4096];
+            ssize_t count = recv(this->fd, buffer, sizeof(buffer), 0);
+            if (count < 0 && (errno == EINTR ||
+                ((errno == EAGAIN || errno == EWOULDBLOCK) && this->Wait(POLLIN))))
+            {
+                continue;
+            }
+            if (count <= 0) {
+                return false;
+            }
+            this->in.append(buffer, (size_t) count);
+        }
+    }
+
+    bool Client::Call(const std::string& request, std::string& response) {
+        if (!this->Connect()) {
+            return false;
+        }
+        this->Queue(request);
+        if (this->Flush() && this->Receive(response)) {
+            return true;
+        }
+        if (this->timedOut) {
+            response = "-timed out waiting for the daemon";
+            return true;
+        }
+        return false;
+    }
+
+    bool Client::Wait(short events) {
+        using namespace std::chrono;
+        auto deadline = cmd::Deadline::Current();
+        while (true) {
+            int timeout = -1;
+            if (deadline != cmd::Deadline::Clock::time_point::max()) {
+                auto left = duration_cast<microseconds>(deadline - cmd::Deadline::Clock::now()).count();
+                timeout = (int) std::min((long long) INT_MAX, std::max(0LL, (long long) (left + 999) / 1000));
+            }
+
+            pollfd fd = { this->fd, events, 0 };
+            int ready = poll(&fd, 1, timeout);
+            if (ready > 0) {
+                return true;
+            }
+            if (ready == 0) {
+                this->timedOut = true;
+                cmd::Deadline::Expire();
+                return false;
+            }
+            if (errno != EINTR) {
+                return false;
+            }
+        }
+    }
+}
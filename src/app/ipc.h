@@ -0,0 +1,85 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2019 casey langen
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the author nor the names of other contributors may
+//      be used to endorse or promote products derived from this software
+//      without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+
+/* the protocol spoken over the daemon's socket. one request per line, one
+response line per request, in order; clients may send any number of
+requests before reading the responses.
+
+    l                       -> +name=brightness name=brightness ...
+    g <devices>             -> +brightness[ brightness ...]
+    s <devices> <value> [<fade-ms> [<easing>]]  -> +
+    d <devices> <delta> [<fade-ms> [<easing>]]  -> +
+
+<devices> is anything cmd::resolve() accepts, and <easing> anything
+cmd::parseEasing() does. fades are acknowledged as soon as they've started,
+and `g` reports their target. failed requests are answered with a line
+starting with '-', followed by a message. */
+namespace ipc {
+    /* $XDG_RUNTIME_DIR/xdimmer.sock, or a per-user path in /tmp */
+    std::string path();
+
+    class Client {
+        public:
+            ~Client();
+
+            /* false if no daemon is listening */
+            bool Connect();
+
+            /* requests are buffered until Flush(); this is how pipelining
+            clients should send them. */
+            void Queue(const std::string& request);
+            bool Flush();
+            bool Receive(std::string& response);
+
+            /* connects on first use. false if there's no daemon, or it went
+            away, in which case callers should do the work themselves. a
+            daemon that doesn't answer before this thread's cmd::Deadline
+            is given up on; that's answered with a '-' response, and the
+            deadline is marked expired, since doing the work ourselves
+            would likely hang on the same thing. */
+            bool Call(const std::string& request, std::string& response);
+
+        private:
+            /* until `events`, or the deadline; see Call() */
+            bool Wait(short events);
+
+            int fd = -1;
+            bool timedOut = false;
+            std::string out, in;
+    };
+}
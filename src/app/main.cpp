@@ -39,18 +39,27 @@
 #include <cursespp/ScrollAdapterBase.h>
 #include <cursespp/LayoutBase.h>
 #include <cursespp/SingleLineEntry.h>
-#include <cursespp/Text.h>
 
 #include <f8n/debug/debug.h>
 #include <f8n/environment/Environment.h>
 
-#include <iostream>
+#include <algorithm>
+#include <fstream>
 #include <vector>
 #include <string>
-#include <cassert>
+#include <mutex>
 
-#include "cxxopts.hpp"
-#include "pstream.h"
+#ifdef __linux__
+#include <sys/prctl.h>
+#endif
+
+#include "cli.h"
+#include "cmd.h"
+#include "Engine.h"
+#include "PollScheduler.h"
+#include "RowCache.h"
+#include "str.h"
+#include "trace.h"
 
 static const std::string APP_NAME = "xdimmer";
 static const int MAX_SIZE = 1000;
@@ -59,179 +68,45 @@ static const int MIN_WIDTH = 24;
 static const int DEFAULT_HEIGHT = 26;
 static const int MIN_HEIGHT = 3;
 static const int MESSAGE_UPDATE = 0xdeadbeef;
+static const int MESSAGE_REFRESHED = 0xdeadbef0;
+static const int WATCH_DEBOUNCE_MS = 50;
+static const int MESSAGE_STATS = 0xdeadbef1;
+static const int STATS_INTERVAL_MS = 60 * 1000;
+static const int MAX_TIMER_SLACK_MS = 100;
+static const int MESSAGE_VALIDATE = 0xdeadbef2;
+static const int VALIDATE_INTERVAL_MS = 5000;
 
 using namespace cursespp;
 
-struct Monitor {
-    const std::string name;
-    const float brightness;
-};
-
-namespace str {
-    std::string trim(const std::string &s) {
-        /* so lazy https://stackoverflow.com/a/17976541 */
-        auto front = std::find_if_not(s.begin(), s.end(), isspace);
-        auto back = std::find_if_not(s.rbegin(), s.rend(), isspace).base();
-        return (back <= front ? std::string() : std::string(front, back));
-    }
-
-    std::vector<std::string> split(const std::string& str, const std::string& delimiters) {
-        using ContainerT = std::vector<std::string>;
-        ContainerT tokens;
-        std::string::size_type pos, lastPos = 0, length = str.length();
-        using value_type = ContainerT::value_type;
-        using size_type = ContainerT::size_type;
-        while (lastPos < length + 1) {
-            pos = str.find_first_of(delimiters, lastPos);
-            if (pos == std::string::npos) {
-                pos = length;
-            }
-            if (pos != lastPos) {
-                std::string token = trim(value_type(
-                    str.data() + lastPos, (size_type) pos - lastPos));
-                if (token.size()) {
-                    tokens.push_back(token);
-                }
+namespace ui {
+    /* everything this process has written so far. that's almost entirely
+    curses' terminal output; the debug log (and --trace) are the rest. -1
+    if unknown (only linux provides it). */
+    static long long bytesWritten() {
+        std::ifstream io("/proc/self/io");
+        std::string key;
+        long long value;
+        while (io >> key >> value) {
+            if (key == "wchar:") {
+                return value;
             }
-            lastPos = pos + 1;
-        }
-        return tokens;
-    }
-
-    int parseIndex(const std::string& value) {
-        try {
-            return std::stoi(value);
-        }
-        catch (...) {
-            /* so slow */
         }
         return -1;
     }
 
-    template<typename... Args>
-    static std::string fmt(const std::string& format, Args ... args) {
-        size_t size = std::snprintf(nullptr, 0, format.c_str(), args ...) + 1; /* extra space for '\0' */
-        std::unique_ptr<char[]> buf(new char[size]);
-        std::snprintf(buf.get(), size, format.c_str(), args ...);
-        return std::string(buf.get(), buf.get() + size - 1); /* omit the '\0' */
-    }
-}
-
-namespace cmd {
-    std::vector<std::string> queryNames() {
-        std::vector<std::string> names;
-        redi::ipstream in("xrandr -q | grep \" connected \"");
-        for (std::string line; std::getline(in, line);) {
-            auto parts = str::split(line, " ");
-            if (parts.size()) {
-                //std::cout << "name: " << parts[0] << "\n";
-                names.push_back(parts[0]);
-            }
-        }
-        return names;
-    }
-
-    std::vector<float> queryValues() {
-        std::vector<float> values;
-        redi::ipstream in("xrandr --verbose | grep -i brightness");
-        for (std::string line; std::getline(in, line);) {
-            auto parts = str::split(line, " ");
-            if (parts.size() > 1) {
-                //std::cout << "value: " << parts[1] << "\n";
-                values.push_back(std::stof(parts[1]));
-            }
-        }
-
-        return values;
-    }
-
-    std::vector<Monitor> query() {
-        auto names = queryNames();
-        auto values = queryValues();
-        assert(names.size() == values.size());
-        std::vector<Monitor> monitors;
-        for (size_t i = 0; i < names.size(); i++) {
-            monitors.push_back(Monitor{names[i], values[i]});
-        }
-        return monitors;
-    }
-
-    float query(const std::string& device) {
-        auto all = query();
-        for (auto d : all) {
-            if (d.name == device) {
-                return d.brightness;
-            }
-        }
-        int index = str::parseIndex(device);
-        if (index >= 0 && all.size() > index) {
-            return all[index].brightness;
-        }
-        std::cerr << "could not find device=" << device << "\n";
-        exit(0);
-    }
-
-    void update(const Monitor& monitor, float brightness) {
-        if (brightness < 0.05) { brightness = 0.05; }
-        if (brightness > 1.0) { brightness = 1.0; }
-        std::string command = str::fmt(
-            "xrandr --output %s --brightness %f\n",
-            monitor.name.c_str(),
-            brightness);
-        //std::cout << command;
-        redi::opstream out(command);
-    }
-
-    void update(const std::string& device, float brightness) {
-        auto all = query();
-        for (auto d : all) {
-            if (d.name == device) {
-                update(d, brightness);
-                return;
-            }
-        }
-        int index = str::parseIndex(device);
-        if (index >= 0 && all.size() > index) {
-            update(all[index], brightness);
-        }
-    }
-}
-
-namespace ui {
-    static std::string formatRow(size_t width, const std::vector<Monitor>& monitors, size_t index) {
-        auto& m = monitors[index];
-
-        size_t maxLeft = 0;
-        for (auto& m: monitors) {
-            if (m.name.size() > maxLeft) {
-                maxLeft = m.name.size();
-            }
-        }
-
-        size_t maxRight = 5; /* ' 100%' */
-
-        std::string leftText = text::Align(
-            m.name, text::AlignRight, (int) maxLeft);
-
-        std::string rightText = text::Align(
-            std::to_string((int)(round(m.brightness * 100.0))) + "%",
-            text::AlignRight,
-            (int) maxRight);
-
-        int trackWidth = (int) width - ((int) maxRight + (int) maxLeft + 3);
-        int thumbOffset = std::max(0, (int)(m.brightness * (float) trackWidth) - 1);
-        std::string trackText = " ";
-        for (int i = 0; i < trackWidth; i++) {
-            trackText += (i == thumbOffset) ? "■" : "─";
-        }
-
-        return " " + leftText + trackText + rightText;
+    /* lets the kernel delay the ui thread's timed wakeups by up to a tenth
+    of the poll interval, so they can be batched with other wakeups. input
+    and posted messages still wake it immediately. */
+    static void setTimerSlack(int intervalMs) {
+#ifdef __linux__
+        long ms = std::min(intervalMs / 10, MAX_TIMER_SLACK_MS);
+        prctl(PR_SET_TIMERSLACK, (unsigned long) std::max(1L, ms) * 1000000UL, 0, 0, 0);
+#endif
     }
 
     class MonitorAdapter: public ScrollAdapterBase {
         public:
             MonitorAdapter() {
-                this->Refresh();
             }
 
             virtual ~MonitorAdapter() {
@@ -241,43 +116,120 @@ namespace ui {
                 return this->monitors.size();
             }
 
+            /* an entry is kept until its row's text changes; see RowCache */
             virtual EntryPtr GetEntry(cursespp::ScrollableWindow* window, size_t index) override {
-                std::string formatted = formatRow(window->GetContentWidth(), this->monitors, index);
-                auto entry = std::make_shared<SingleLineEntry>(formatted);
-                entry->SetAttrs(Color::Default);
-                if (index == window->GetScrollPosition().logicalIndex) {
-                    entry->SetAttrs(Color::ListItemHighlighted);
+                auto& entry = this->entries[index];
+                {
+                    trace::Span span("ui", "formatRow");
+                    size_t width = window->GetContentWidth();
+                    if (this->rows.Format(index, width, this->monitors[index]) || !entry) {
+                        entry = std::make_shared<SingleLineEntry>(this->rows.Text(index));
+                    }
                 }
+                entry->SetAttrs((index == window->GetScrollPosition().logicalIndex)
+                    ? Color::ListItemHighlighted : Color::Default);
                 return entry;
             }
 
-            void Update(size_t index, float delta) {
+            const Monitor& At(size_t index) const {
+                return this->monitors[index];
+            }
+
+            /* applies `delta` to the local copy right away, so the row can be
+            redrawn before the backend has caught up; returns the new value. */
+            float Adjust(size_t index, float delta) {
                 auto& m = this->monitors[index];
-                float newValue = m.brightness + delta;
-                if (newValue > 1.0) { newValue = 1.0; }
-                if (newValue < 0.0) { newValue = 0.0; }
-                cmd::update(m, newValue);
-                this->Refresh();
+                m.brightness = cmd::clamp(m.brightness + delta);
+                return m.brightness;
             }
 
-            void Refresh() {
-                this->monitors = cmd::query();
+            /* returns the number of rows that look different now. if the
+            same outputs are listed in the same order, their rows (and
+            entries) are kept and only the ones that changed are redone;
+            otherwise every row is. */
+            size_t SetMonitors(std::vector<Monitor>&& monitors) {
+                bool same = (monitors.size() == this->monitors.size());
+                for (size_t i = 0; same && i < monitors.size(); i++) {
+                    same = (monitors[i].name == this->monitors[i].name);
+                }
+
+                if (!same) {
+                    this->monitors = std::move(monitors);
+                    this->rows.Reset(this->monitors);
+                    this->entries.assign(this->monitors.size(), nullptr);
+                    return std::max((size_t) 1, this->monitors.size());
+                }
+
+                /* by what the rows show; our own writes accumulate float
+                error that the server's (rounded) values don't have */
+                size_t changed = 0;
+                for (size_t i = 0; i < monitors.size(); i++) {
+                    if (RowCache::Percent(monitors[i]) != RowCache::Percent(this->monitors[i])) {
+                        ++changed;
+                    }
+                }
+                this->monitors = std::move(monitors);
+                return changed;
             }
 
         private:
             std::vector<Monitor> monitors;
+            std::vector<std::shared_ptr<SingleLineEntry>> entries;
+            RowCache rows;
     };
 
     class MainLayout: public LayoutBase {
         public:
-            MainLayout() : LayoutBase() {
+            MainLayout(const Settings& settings)
+            : LayoutBase(), settings(settings), poll(settings.pollMaxMs) {
                 this->adapter = std::make_shared<MonitorAdapter>();
                 this->listWindow = std::make_shared<ListWindow>(this->adapter);
                 this->AddWindow(this->listWindow);
                 this->listWindow->SetFocusOrder(0);
                 this->listWindow->SetFrameVisible(true);
                 this->listWindow->SetFrameTitle("xdimmer");
-                this->Post(MESSAGE_UPDATE, 0, 0, 1000);
+
+                /* all backend work happens on the engine's thread; results
+                are stashed and picked up on the ui thread. the adapter's list
+                is the source of truth in between; it's updated optimistically
+                on every write, and only reconciled with the server when a
+                change notification (or, without one, the poll) comes in. */
+                this->engine.reset(new cmd::Engine(
+                    [this](const cmd::Engine::Result& result) {
+                        if (result.probe == cmd::Probe::Full) {
+                            this->LogRescan();
+                        }
+                        {
+                            std::unique_lock<std::mutex> lock(this->pendingLock);
+                            this->pending = result;
+                            this->hasPending = true;
+                        }
+                        this->Post(MESSAGE_REFRESHED);
+                    },
+                    settings.writeIntervalMs));
+
+                this->engine->Refresh();
+
+                /* prefer change notifications from the server; they're
+                delivered on a background thread, so just post a (debounced,
+                because they tend to arrive in bursts) message and handle it
+                on the ui thread. if the backend can't notify us, poll. */
+                this->watcher = cmd::watch([this]() {
+                    this->Debounce(MESSAGE_UPDATE, 0, 0, WATCH_DEBOUNCE_MS);
+                });
+
+                if (!this->watcher) {
+                    this->SchedulePoll();
+                }
+                else {
+                    /* notifications don't cover gamma, so brightness set by
+                    another process (the cli, the daemon) would otherwise
+                    never show up, and our next write would clobber it */
+                    this->Post(MESSAGE_VALIDATE, 0, 0, VALIDATE_INTERVAL_MS);
+                }
+
+                this->lastBytesWritten = bytesWritten();
+                this->Post(MESSAGE_STATS, 0, 0, STATS_INTERVAL_MS);
             }
 
             virtual void OnLayout() override {
@@ -286,6 +238,8 @@ namespace ui {
             }
 
             virtual bool KeyPress(const std::string& key) override {
+                this->Activity();
+
                 if (key == "KEY_LEFT") {
                     this->UpdateSelected(-0.05);
                     return true;
@@ -310,14 +264,56 @@ namespace ui {
                     this->UpdateAll(0.10);
                     return true;
                 }
+                else if (key == "r") {
+                    this->Rescan();
+                    return true;
+                }
                 return false;
             }
 
             virtual void ProcessMessage(f8n::runtime::IMessage &message) override {
                 if (message.Type() == MESSAGE_UPDATE) {
-                    this->adapter->Refresh();
-                    this->listWindow->OnAdapterChanged();
-                    this->Post(MESSAGE_UPDATE, 0, 0, 1000);
+                    this->engine->Refresh();
+                    if (!this->watcher) {
+                        this->SchedulePoll();
+                    }
+                    return;
+                }
+                else if (message.Type() == MESSAGE_REFRESHED) {
+                    std::unique_lock<std::mutex> lock(this->pendingLock);
+                    if (this->hasPending) {
+                        /* something may have been written since the query
+                        started; our model is newer in that case */
+                        if (this->engine->IsCurrent(this->pending.generation)) {
+                            size_t changed;
+                            {
+                                trace::Span span("ui", "model update");
+                                changed = this->adapter->SetMonitors(std::move(this->pending.monitors));
+                            }
+                            /* the usual case while idle; leave the screen be.
+                            otherwise it was changed from outside (our own
+                            writes are already in the model), and more
+                            changes tend to follow. */
+                            if (changed) {
+                                this->Redraw();
+                                this->Activity();
+                            }
+                            else {
+                                ++this->skippedRedraws;
+                            }
+                        }
+                        this->hasPending = false;
+                    }
+                    return;
+                }
+                else if (message.Type() == MESSAGE_VALIDATE) {
+                    this->engine->Validate();
+                    this->Post(MESSAGE_VALIDATE, 0, 0, VALIDATE_INTERVAL_MS);
+                    return;
+                }
+                else if (message.Type() == MESSAGE_STATS) {
+                    this->LogStats();
+                    this->Post(MESSAGE_STATS, 0, 0, STATS_INTERVAL_MS);
                     return;
                 }
 
@@ -325,100 +321,115 @@ namespace ui {
             }
 
         private:
+            void Rescan() {
+                this->engine->Rescan();
+            }
+
+            /* called on the engine's thread, which owns the stats */
+            void LogRescan() {
+                auto& full = cmd::stats(cmd::Probe::Full);
+                auto& current = cmd::stats(cmd::Probe::Current);
+                f8n::debug::info("MainLayout", str::fmt(
+                    "rescan took %.1fms; cached queries average %.1fms",
+                    full.lastMs,
+                    current.count ? current.totalMs / current.count : 0.0));
+            }
+
+            /* the next poll, if we have to poll; replaces one that's
+            already scheduled */
+            void SchedulePoll() {
+                int delay = this->poll.Next();
+                setTimerSlack(delay);
+                this->Debounce(MESSAGE_UPDATE, 0, 0, delay);
+            }
+
+            void Activity() {
+                if (!this->watcher) {
+                    this->poll.Activity();
+                    this->SchedulePoll();
+                }
+            }
+
+            /* how much we've been drawing; mostly of interest when idle, and
+            over slow links (ssh, tmux) */
+            void LogStats() {
+                long long bytes = bytesWritten();
+                if (bytes >= 0 && this->lastBytesWritten >= 0) {
+                    f8n::debug::info("MainLayout", str::fmt(
+                        "%lld bytes written in the last minute; %d redraws, %d skipped",
+                        bytes - this->lastBytesWritten,
+                        this->redraws,
+                        this->skippedRedraws));
+                }
+                this->lastBytesWritten = bytes;
+                this->redraws = this->skippedRedraws = 0;
+            }
+
             void UpdateSelected(float delta) {
                 auto index = this->listWindow->GetSelectedIndex();
-                this->adapter->Update(index, delta);
-                this->listWindow->OnAdapterChanged();
+                if (index < this->adapter->GetEntryCount()) {
+                    this->Update(index, delta);
+                    this->Redraw();
+                }
             }
 
             void UpdateAll(float delta) {
+                std::vector<cmd::Write> writes;
                 for (size_t i = 0; i < this->adapter->GetEntryCount(); i++) {
-                    this->adapter->Update(i, delta);
+                    /* the fade starts from the brightness before the adjustment */
+                    Monitor from = this->adapter->At(i);
+                    float value = this->adapter->Adjust(i, delta);
+                    writes.push_back({ from, value });
                 }
+                this->engine->Fade(writes, this->settings.fadeMs, this->settings.easing);
+                this->Redraw();
+            }
+
+            /* curses only sends the terminal the lines that differ from
+            what's on screen, so a redraw where one row changed costs one
+            line of output */
+            void Redraw() {
+                trace::Span span("ui", "redraw");
+                ++this->redraws;
                 this->listWindow->OnAdapterChanged();
             }
 
+            void Update(size_t index, float delta) {
+                float value = this->adapter->Adjust(index, delta);
+                this->engine->Update(this->adapter->At(index), value);
+            }
+
+            Settings settings;
+            PollScheduler poll;
             std::shared_ptr<ListWindow> listWindow;
             std::shared_ptr<MonitorAdapter> adapter;
+            std::mutex pendingLock;
+            cmd::Engine::Result pending;
+            bool hasPending = false;
+            long long lastBytesWritten = -1;
+            int redraws = 0, skippedRedraws = 0;
+            /* last; these call back into us from other threads, so they
+            need to be stopped before anything else is destroyed */
+            std::unique_ptr<cmd::Engine> engine;
+            std::unique_ptr<cmd::Watcher> watcher;
     };
 }
 
-bool handleCommandLine(int argc, char* argv[]) {
-    cxxopts::Options options("xdimmer", "");
-
-    options
-        .add_options("all")
-        ("list", "List all device names")
-        ("get", "Get the brightness for the specified device")
-        ("set", "Set the brightness for the specified device")
-        ("delta", "Apply a brightness delta to the specified device", cxxopts::value<std::string>())
-        ("device", "Device name or index", cxxopts::value<std::string>())
-        ("value", "Brightness value", cxxopts::value<float>())
-        ("help", "Display help");
-
-    auto result = options.parse(argc, argv);
-
-    if (result.count("list")) {
-        auto devices = cmd::query();
-        int i = 0;
-        for (auto d: devices) {
-            std::cout << "[" << i++ << "] " << d.name << ": " << d.brightness << "\n";
-        }
-        return true;
-    }
-    else if (result.count("get")) {
-        if (!result.count("device")) {
-            goto printhelp;
-        }
-        std::string device = result["device"].as<std::string>();
-        std::cout << cmd::query(device);
-        return true;
-    }
-    else if (result.count("set")) {
-        if (!result.count("device") || 
-            (!result.count("value") && !result.count("delta")))
-        {
-            goto printhelp;
-        }
-        else if (result.count("value")) {
-            float value = result["value"].as<float>();
-            std::string device = result["device"].as<std::string>();
-            cmd::update(device, value);
-        }
-        else if (result.count("delta")) {
-            std::string delta = result["delta"].as<std::string>();
-            try {
-                std::string device = result["device"].as<std::string>();
-                float d = std::stof(delta);
-                cmd::update(device, cmd::query(device) + d);
-            }
-            catch (...) {
-                std::cerr << "invalid delta '" << delta << "' specified\n";
-                exit(0);
-            }
-        }
-        return true;
-    }
-    else if (result.count("help")) {
-        goto printhelp;
-    }
-
-    return false;
-
-printhelp:
-    std::cout << options.help({"", "all"}) << std::endl;
-    exit(0);
-}
-
 int main(int argc, char* argv[]) {
-    if (!handleCommandLine(argc, argv)) {
+    Settings settings;
+    if (!handleCommandLine(argc, argv, settings)) {
         f8n::env::Initialize(APP_NAME, 1);
         f8n::debug::Start({ new f8n::debug::SimpleFileBackend() });
+        if (settings.traceToDebug) {
+            trace::route([](const char* category, const char* name, double ms) {
+                f8n::debug::info("trace", str::fmt("%s: %s %.3fms", category, name, ms));
+            });
+        }
         App app(APP_NAME);
         app.SetMinimumSize(MIN_WIDTH, MIN_HEIGHT);
         app.SetColorMode(Colors::RGB);
         app.SetColorBackgroundType(Colors::Inherit);
-        app.Run(std::make_shared<ui::MainLayout>());
+        app.Run(std::make_shared<ui::MainLayout>(settings));
         f8n::debug::Stop();
     }
     return 0;
@@ -31,16 +31,25 @@
 #include <sys/types.h>  // for pid_t
 #include <sys/wait.h>   // for waitpid()
 #include <sys/ioctl.h>  // for ioctl() and FIONREAD
+#include <poll.h>       // for poll()
+#include <chrono>       // for deadlines
+#include <mutex>        // for abandoned_pids()
+#if defined(__linux__)
+# include <sys/syscall.h> // for SYS_pidfd_open
+#endif
 #if defined(__sun)
 # include <sys/filio.h> // for FIONREAD on Solaris 2.5
 #endif
 #include <unistd.h>     // for pipe() fork() exec() and filedes functions
-#include <signal.h>     // for kill()
+#include <signal.h>     // for kill() sigemptyset()
 #include <fcntl.h>      // for fcntl()
+#include <spawn.h>      // for posix_spawnp()
 #if REDI_EVISCERATE_PSTREAMS
 # include <stdio.h>     // for FILE, fdopen()
 #endif
 
+extern char** environ;  // for posix_spawnp()
+
 
 /// The library version.
 #define PSTREAMS_VERSION 0x0101   // 1.0.1
@@ -79,8 +88,23 @@ namespace redi
     /// Create a new process group for the child process.
     static const pmode newpg   = std::ios_base::trunc;
 
+    /// Clock used for deadlines.
+    typedef std::chrono::steady_clock         clock_type;
+
+    /// How long close() waits after each of SIGTERM and SIGKILL.
+    enum { kill_grace_ms = 100 };
+
+    /**
+     * Start the child with posix_spawnp() instead of fork() and exec().
+     * Only honoured by the argv_type overloads of open(). The parent's page
+     * tables aren't copied (glibc implements posix_spawn with
+     * clone(CLONE_VM|CLONE_VFORK)), so the cost of starting a process no
+     * longer grows with the parent's resident set size.
+     */
+    static const pmode spawn   = std::ios_base::ate;
+
   protected:
-    enum { bufsz = 32 };  ///< Size of pstreambuf buffers.
+    enum { bufsz = 32 };  ///< Default size of pstreambuf buffers.
     enum { pbsz  = 2 };   ///< Number of putback characters kept.
   };
 
@@ -150,6 +174,27 @@ namespace redi
       bool
       exited();
 
+      /// Set the size of the buffers allocated by subsequent calls to open().
+      bool
+      buffer_size(std::size_t n);
+
+      /// Return the size of the buffers allocated by open().
+      std::size_t
+      buffer_size() const;
+
+      /// Extract a line without copying it out of the read buffer.
+      bool
+      read_line(const char_type*& line, std::streamsize& length,
+                char_type delim = char_type('\n'));
+
+      /// Bound the time reads and close() may block for.
+      void
+      deadline(clock_type::time_point when);
+
+      /// Report whether the deadline passed before the process was done.
+      bool
+      expired() const;
+
 #if REDI_EVISCERATE_PSTREAMS
       /// Obtain FILE pointers for each of the process' standard streams.
       std::size_t
@@ -205,10 +250,22 @@ namespace redi
       pid_t
       fork(pmode mode);
 
+      /// Initialise pipes and start @a file with posix_spawnp().
+      pid_t
+      spawn_child(const std::string& file, const argv_type& argv, pmode mode);
+
       /// Wait for the child process to exit.
       int
       wait(bool nohang = false);
 
+      /// Wait for the child process to exit, until @a until at the latest.
+      bool
+      wait_until(clock_type::time_point until);
+
+      /// Wait for the active input pipe to become readable, until the deadline.
+      bool
+      wait_readable();
+
       /// Return the file descriptor for the output pipe.
       fd_type&
       wpipe();
@@ -227,6 +284,9 @@ namespace redi
       void
       destroy_buffers(pmode mode);
 
+      void
+      free_buffers();
+
       /// Writes buffered characters to the process' stdin pipe.
       bool
       empty_buffer();
@@ -253,11 +313,16 @@ namespace redi
       fd_type       rpipe_[2];    // two pipes to read from, stdout and stderr
       char_type*    wbuffer_;
       char_type*    rbuffer_[2];
+      std::size_t   bufsz_;       // size of buffers allocated by open()
+      std::size_t   wbufsz_;      // actual size of wbuffer_
+      std::size_t   rbufsz_[2];   // actual sizes of rbuffer_[]
       char_type*    rbufstate_[3];
       /// Index into rpipe_[] to indicate active source for read operations.
       buf_read_src  rsrc_;
       int           status_;      // hold exit status of child process
       int           error_;       // hold errno if fork() or exec() fails
+      clock_type::time_point deadline_;
+      bool          expired_;     // deadline_ passed before the process was done
     };
 
   /// Class template for common base class.
@@ -1004,9 +1069,13 @@ namespace redi
     : ppid_(-1)   // initialise to -1 to indicate no process run yet.
     , wpipe_(-1)
     , wbuffer_(NULL)
+    , bufsz_(bufsz)
+    , wbufsz_(0)
     , rsrc_(rsrc_out)
     , status_(-1)
     , error_(0)
+    , deadline_(clock_type::time_point::max())
+    , expired_(false)
     {
       init_rbuffers();
     }
@@ -1025,9 +1094,13 @@ namespace redi
     : ppid_(-1)   // initialise to -1 to indicate no process run yet.
     , wpipe_(-1)
     , wbuffer_(NULL)
+    , bufsz_(bufsz)
+    , wbufsz_(0)
     , rsrc_(rsrc_out)
     , status_(-1)
     , error_(0)
+    , deadline_(clock_type::time_point::max())
+    , expired_(false)
     {
       init_rbuffers();
       open(cmd, mode);
@@ -1050,9 +1123,13 @@ namespace redi
     : ppid_(-1)   // initialise to -1 to indicate no process run yet.
     , wpipe_(-1)
     , wbuffer_(NULL)
+    , bufsz_(bufsz)
+    , wbufsz_(0)
     , rsrc_(rsrc_out)
     , status_(-1)
     , error_(0)
+    , deadline_(clock_type::time_point::max())
+    , expired_(false)
     {
       init_rbuffers();
       open(file, argv, mode);
@@ -1067,6 +1144,7 @@ namespace redi
     basic_pstreambuf<C,T>::~basic_pstreambuf()
     {
       close();
+      free_buffers();
     }
 
   /**
@@ -1107,6 +1185,9 @@ namespace redi
 #else
       basic_pstreambuf<C,T>* ret = NULL;
 
+      if (!is_open())
+        error_ = 0;  // e.g. ETIMEDOUT, left by the last close()
+
       if (!is_open())
       {
         switch(fork(mode))
@@ -1169,6 +1250,61 @@ namespace redi
         close_fd(fds[i]);
     }
 
+  /**
+   * @brief  Helper function to reap children that close() gave up on.
+   *
+   * A process that survives SIGKILL is stuck in the kernel (e.g. in an
+   * uninterruptible ioctl). Rather than blocking on it, close() hands it
+   * over here; it's reaped by whichever close() runs after it has exited,
+   * so they don't pile up as zombies.
+   *
+   * @param   pid  a process to add, or 0 to just reap.
+   * @relates basic_pstreambuf
+   */
+  inline void
+  reap_abandoned(pid_t pid = 0)
+  {
+    static std::mutex lock;
+    static std::vector<pid_t> pids;
+
+    std::lock_guard<std::mutex> guard(lock);
+    if (pid > 0)
+      pids.push_back(pid);
+
+    for (std::size_t i = 0; i < pids.size(); )
+    {
+      int status;
+      if (::waitpid(pids[i], &status, WNOHANG) != 0)
+      {
+        pids[i] = pids.back();
+        pids.pop_back();
+      }
+      else
+        ++i;
+    }
+  }
+
+  /**
+   * @brief  Helper function to compute the time left until @a until.
+   *
+   * @return  milliseconds, rounded up, suitable for poll(); 0 if
+   *          @a until has passed, -1 if it's the maximum time_point.
+   * @relates basic_pstreambuf
+   */
+  inline int
+  remaining_ms(pstreams::clock_type::time_point until)
+  {
+    typedef pstreams::clock_type clock_type;
+    if (until == clock_type::time_point::max())
+      return -1;
+    const clock_type::time_point now = clock_type::now();
+    if (until <= now)
+      return 0;
+    const long long us = std::chrono::duration_cast<std::chrono::microseconds>(
+        until - now).count();
+    return int(std::min<long long>((us + 999) / 1000, 0x7fffffff));
+  }
+
   /**
    * Starts a new process by executing @a file with the arguments in
    * @a argv and opens pipes to the process with the specified @a mode.
@@ -1207,6 +1343,18 @@ namespace redi
       basic_pstreambuf<C,T>* ret = NULL;
 
       if (!is_open())
+        error_ = 0;  // e.g. ETIMEDOUT, left by the last close()
+
+      if (!is_open() && (mode & spawn))
+      {
+        // posix_spawnp() reports exec() failures itself, no ck_exec pipe
+        if (spawn_child(file, argv, mode) > 0)
+        {
+          create_buffers(mode);
+          ret = this;
+        }
+      }
+      else if (!is_open())
       {
         // constants for read/write ends of pipe
         enum { RD, WR };
@@ -1412,6 +1560,163 @@ namespace redi
       return pid;
     }
 
+  /**
+   * @brief  Helper function to open a pipe with close-on-exec set on both ends.
+   *
+   * Uses <b>pipe2</b>(2) where available so there's no window in which
+   * another thread's fork() could inherit the descriptors.
+   *
+   * @param   fds  an array of two file descriptors.
+   * @return  0 on success, -1 on failure with @c errno set.
+   * @relates basic_pstreambuf
+   */
+  inline int
+  pipe_cloexec(pstreams::fd_type (&fds)[2])
+  {
+#if defined(__linux__) || defined(__FreeBSD__)
+    return ::pipe2(fds, O_CLOEXEC);
+#else
+    if (::pipe(fds) == -1)
+      return -1;
+    if (::fcntl(fds[0], F_SETFD, FD_CLOEXEC) == -1
+        || ::fcntl(fds[1], F_SETFD, FD_CLOEXEC) == -1)
+    {
+      const int err = errno;
+      close_fd_array(fds);
+      errno = err;
+      return -1;
+    }
+    return 0;
+#endif
+  }
+
+  /**
+   * Creates close-on-exec pipes as specified by @a mode and starts @a file
+   * with <b>posix_spawnp</b>(3). The child's ends of the pipes are installed
+   * as its standard streams with file actions; every other descriptor is
+   * either close-on-exec already or, where supported, closed in one go with
+   * <b>close_range</b>(2) via posix_spawn_file_actions_addclosefrom_np().
+   *
+   * If an error occurs the error code will be set to one of the possible
+   * errors for @c pipe() or @c posix_spawnp(), including exec() failures.
+   *
+   * @param   file  a string containing the pathname of a program to execute.
+   * @param   argv  a vector of argument strings passed to the new program.
+   * @param   mode  an OR of pmodes specifying which of the child's
+   *                standard streams to connect to.
+   * @return  The PID of the child, or -1 on error.
+   */
+  template <typename C, typename T>
+    pid_t
+    basic_pstreambuf<C,T>::spawn_child( const std::string& file,
+                                        const argv_type& argv,
+                                        pmode mode )
+    {
+      pid_t pid = -1;
+
+      fd_type pin[] = { -1, -1 };
+      fd_type pout[] = { -1, -1 };
+      fd_type perr[] = { -1, -1 };
+
+      // constants for read/write ends of pipe
+      enum { RD, WR };
+
+      if (!error_ && mode&pstdin && pipe_cloexec(pin))
+        error_ = errno;
+
+      if (!error_ && mode&pstdout && pipe_cloexec(pout))
+        error_ = errno;
+
+      if (!error_ && mode&pstderr && pipe_cloexec(perr))
+        error_ = errno;
+
+      if (!error_)
+      {
+        posix_spawn_file_actions_t actions;
+        posix_spawnattr_t attr;
+        ::posix_spawn_file_actions_init(&actions);
+        ::posix_spawnattr_init(&attr);
+
+        // dup2() clears close-on-exec on the target descriptor
+        if (*pin >= 0)
+          ::posix_spawn_file_actions_adddup2(&actions, pin[RD], STDIN_FILENO);
+        if (*pout >= 0)
+          ::posix_spawn_file_actions_adddup2(&actions, pout[WR], STDOUT_FILENO);
+        if (*perr >= 0)
+          ::posix_spawn_file_actions_adddup2(&actions, perr[WR], STDERR_FILENO);
+
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 34))
+        ::posix_spawn_file_actions_addclosefrom_np(&actions, STDERR_FILENO + 1);
+#endif
+
+        // the child would otherwise inherit the caller's blocked signals,
+        // e.g. SIGTERM blocked for a signalfd, and ignore being killed
+        sigset_t unblocked;
+        ::sigemptyset(&unblocked);
+        ::posix_spawnattr_setsigmask(&attr, &unblocked);
+
+        short flags = POSIX_SPAWN_SETSIGMASK;
+#ifdef POSIX_SPAWN_USEVFORK
+        flags |= POSIX_SPAWN_USEVFORK;
+#endif
+#ifdef _POSIX_JOB_CONTROL
+        if (mode&newpg)
+        {
+          flags |= POSIX_SPAWN_SETPGROUP;
+          ::posix_spawnattr_setpgroup(&attr, 0);
+        }
+#endif
+        ::posix_spawnattr_setflags(&attr, flags);
+
+        // posix_spawnp() doesn't modify its arguments, but isn't const
+        std::vector<char*> arg_v;
+        arg_v.reserve(argv.size() + 1);
+        for (std::size_t i = 0; i < argv.size(); ++i)
+          arg_v.push_back(const_cast<char*>(argv[i].c_str()));
+        arg_v.push_back(NULL);
+
+        const int rc = ::posix_spawnp(
+          &pid, file.c_str(), &actions, &attr, &arg_v[0], environ);
+
+        ::posix_spawnattr_destroy(&attr);
+        ::posix_spawn_file_actions_destroy(&actions);
+
+        if (rc != 0)
+        {
+          error_ = rc;
+          pid = -1;
+        }
+        else
+        {
+          ppid_ = pid;
+
+          // keep our end of each pipe, close the child's end
+          if (*pin >= 0)
+          {
+            wpipe_ = pin[WR];
+            pin[WR] = -1;
+          }
+          if (*pout >= 0)
+          {
+            rpipe_[rsrc_out] = pout[RD];
+            pout[RD] = -1;
+          }
+          if (*perr >= 0)
+          {
+            rpipe_[rsrc_err] = perr[RD];
+            perr[RD] = -1;
+          }
+        }
+      }
+
+      // on success only the child's ends are left; on failure, everything
+      close_fd_array(pin);
+      close_fd_array(pout);
+      close_fd_array(perr);
+
+      return pid;
+    }
+
   /**
    * Closes all pipes and calls wait() to wait for the process to finish.
    * If an error occurs the error code will be set to one of the possible
@@ -1438,10 +1743,34 @@ namespace redi
       close_fd(wpipe_);
       close_fd_array(rpipe_);
 
-      do
+      reap_abandoned();
+
+      if (deadline_ == clock_type::time_point::max())
       {
-        error_ = 0;
-      } while (wait() == -1 && error() == EINTR);
+        do
+        {
+          error_ = 0;
+        } while (wait() == -1 && error() == EINTR);
+      }
+      else if (is_open() && !wait_until(deadline_))
+      {
+        // out of time: ask nicely, then not so nicely, then give up
+        expired_ = true;
+        static const int signals[] = { SIGTERM, SIGKILL };
+        bool reaped = false;
+        for (int i = 0; i < 2 && !reaped; ++i)
+        {
+          kill(signals[i]);
+          reaped = wait_until(clock_type::now()
+              + std::chrono::milliseconds(int(kill_grace_ms)));
+        }
+        if (!reaped && is_open())
+        {
+          reap_abandoned(ppid_);
+          ppid_ = 0;
+        }
+        error_ = ETIMEDOUT;
+      }
 
       return running ? this : NULL;
     }
@@ -1455,31 +1784,46 @@ namespace redi
     {
       rpipe_[rsrc_out] = rpipe_[rsrc_err] = -1;
       rbuffer_[rsrc_out] = rbuffer_[rsrc_err] = NULL;
+      rbufsz_[rsrc_out] = rbufsz_[rsrc_err] = 0;
       rbufstate_[0] = rbufstate_[1] = rbufstate_[2] = NULL;
     }
 
+  /**
+   * Activates the buffers for the streams in @a mode. Buffers are only
+   * allocated the first time they're needed (or after buffer_size() has
+   * changed); after that they're reused by every subsequent open().
+   */
   template <typename C, typename T>
     void
     basic_pstreambuf<C,T>::create_buffers(pmode mode)
     {
       if (mode & pstdin)
       {
-        delete[] wbuffer_;
-        wbuffer_ = new char_type[bufsz];
-        this->setp(wbuffer_, wbuffer_ + bufsz);
+        if (!wbuffer_)
+        {
+          wbuffer_ = new char_type[bufsz_];
+          wbufsz_ = bufsz_;
+        }
+        this->setp(wbuffer_, wbuffer_ + wbufsz_);
       }
       if (mode & pstdout)
       {
-        delete[] rbuffer_[rsrc_out];
-        rbuffer_[rsrc_out] = new char_type[bufsz];
+        if (!rbuffer_[rsrc_out])
+        {
+          rbuffer_[rsrc_out] = new char_type[bufsz_];
+          rbufsz_[rsrc_out] = bufsz_;
+        }
         rsrc_ = rsrc_out;
         this->setg(rbuffer_[rsrc_out] + pbsz, rbuffer_[rsrc_out] + pbsz,
             rbuffer_[rsrc_out] + pbsz);
       }
       if (mode & pstderr)
       {
-        delete[] rbuffer_[rsrc_err];
-        rbuffer_[rsrc_err] = new char_type[bufsz];
+        if (!rbuffer_[rsrc_err])
+        {
+          rbuffer_[rsrc_err] = new char_type[bufsz_];
+          rbufsz_[rsrc_err] = bufsz_;
+        }
         if (!(mode & pstdout))
         {
           rsrc_ = rsrc_err;
@@ -1489,6 +1833,10 @@ namespace redi
       }
     }
 
+  /**
+   * Deactivates the buffers for the streams in @a mode. The memory is kept
+   * for reuse by the next open(); see free_buffers().
+   */
   template <typename C, typename T>
     void
     basic_pstreambuf<C,T>::destroy_buffers(pmode mode)
@@ -1496,25 +1844,37 @@ namespace redi
       if (mode & pstdin)
       {
         this->setp(NULL, NULL);
-        delete[] wbuffer_;
-        wbuffer_ = NULL;
       }
       if (mode & pstdout)
       {
         if (rsrc_ == rsrc_out)
           this->setg(NULL, NULL, NULL);
-        delete[] rbuffer_[rsrc_out];
-        rbuffer_[rsrc_out] = NULL;
       }
       if (mode & pstderr)
       {
         if (rsrc_ == rsrc_err)
           this->setg(NULL, NULL, NULL);
-        delete[] rbuffer_[rsrc_err];
-        rbuffer_[rsrc_err] = NULL;
       }
     }
 
+  /** Releases the memory used by all buffers. */
+  template <typename C, typename T>
+    void
+    basic_pstreambuf<C,T>::free_buffers()
+    {
+      destroy_buffers(pstdin|pstdout|pstderr);
+      delete[] wbuffer_;
+      wbuffer_ = NULL;
+      wbufsz_ = 0;
+      for (std::size_t i = 0; i < 2; ++i)
+      {
+        delete[] rbuffer_[i];
+        rbuffer_[i] = NULL;
+        rbufsz_[i] = 0;
+      }
+      rbufstate_[0] = rbufstate_[1] = rbufstate_[2] = NULL;
+    }
+
   template <typename C, typename T>
     typename basic_pstreambuf<C,T>::buf_read_src
     basic_pstreambuf<C,T>::switch_read_buffer(buf_read_src src)
@@ -1579,6 +1939,109 @@ namespace redi
       return child_exited;
     }
 
+  /**
+   * Waits for the child process to exit, but not beyond @a until. Where
+   * the kernel supports it (Linux 5.3+) this sleeps on a pidfd, which
+   * becomes readable when the process exits; otherwise it polls with
+   * <b>waitpid</b>(WNOHANG) every few milliseconds.
+   *
+   * @param   until  the latest time to return at.
+   * @return  true if the process has been reaped (or there was none),
+   *          false if it's still running.
+   */
+  template <typename C, typename T>
+    bool
+    basic_pstreambuf<C,T>::wait_until(clock_type::time_point until)
+    {
+      int pidfd = -1;
+#if defined(__linux__) && defined(SYS_pidfd_open)
+      if (is_open())
+        pidfd = int(::syscall(SYS_pidfd_open, ppid_, 0));
+#endif
+      bool done = false;
+      for (;;)
+      {
+        error_ = 0;
+        const int rc = wait(true);
+        if (rc == 1 || (rc == -1 && error_ != EINTR))
+        {
+          done = true;
+          break;
+        }
+        const int ms = remaining_ms(until);
+        if (ms == 0)
+          break;
+        if (pidfd >= 0)
+        {
+          pollfd fd = { pidfd, POLLIN, 0 };
+          ::poll(&fd, 1, ms);
+        }
+        else
+          ::poll(NULL, 0, ms < 0 || ms > 5 ? 5 : ms);
+      }
+      if (pidfd >= 0)
+        ::close(pidfd);
+      return done;
+    }
+
+  /**
+   * Blocks until the active input pipe is readable (or at EOF), or the
+   * deadline passes, whichever is first. In the latter case the error is
+   * set to @c ETIMEDOUT.
+   *
+   * @return  true if a read won't block, false if the deadline passed.
+   */
+  template <typename C, typename T>
+    bool
+    basic_pstreambuf<C,T>::wait_readable()
+    {
+      if (deadline_ == clock_type::time_point::max())
+        return true;
+      for (;;)
+      {
+        pollfd fd = { rpipe(), POLLIN, 0 };
+        const int rc = ::poll(&fd, 1, remaining_ms(deadline_));
+        if (rc == 0)
+        {
+          expired_ = true;
+          error_ = ETIMEDOUT;
+          return false;
+        }
+        if (rc > 0 || errno != EINTR)
+          return true;  // let read() report any error
+      }
+    }
+
+  /**
+   * Sets a time after which reads stop waiting for output, failing with
+   * @c ETIMEDOUT, and close() stops waiting for the process to exit and
+   * sends it SIGTERM, then SIGKILL, @c kill_grace_ms apart. If it's still
+   * around after that it's left to be reaped later, and close() returns
+   * without it. Applies to the current process and subsequent ones, until
+   * it's changed; clock_type::time_point::max() (the default) means no
+   * deadline, i.e. block for as long as it takes.
+   *
+   * @param   when  the deadline.
+   */
+  template <typename C, typename T>
+    inline void
+    basic_pstreambuf<C,T>::deadline(clock_type::time_point when)
+    {
+      deadline_ = when;
+      expired_ = false;
+    }
+
+  /**
+   * @return  true if a read or close() ran into the deadline, i.e. the
+   *          process was cut short.
+   */
+  template <typename C, typename T>
+    inline bool
+    basic_pstreambuf<C,T>::expired() const
+    {
+      return expired_;
+    }
+
   /**
    * Sends the specified signal to the process.  A signal can be used to
    * terminate a child process that would not exit otherwise.
@@ -1663,6 +2126,125 @@ namespace redi
     }
 
 
+  /**
+   * Sets the size, in characters, of the buffers that will be allocated
+   * for the pipes. Larger buffers mean fewer <b>read</b>(2) calls for
+   * commands that produce a lot of output. Can't be changed while a
+   * process is running; any existing buffers are released.
+   *
+   * @param   n  the new buffer size, must be greater than the putback area.
+   * @return  true if the size was changed, false otherwise.
+   */
+  template <typename C, typename T>
+    inline bool
+    basic_pstreambuf<C,T>::buffer_size(std::size_t n)
+    {
+      if (is_open() || n <= std::size_t(pbsz))
+        return false;
+      if (n != bufsz_)
+      {
+        free_buffers();
+        bufsz_ = n;
+      }
+      return true;
+    }
+
+  /** @return  the size of the buffers allocated by open(). */
+  template <typename C, typename T>
+    inline std::size_t
+    basic_pstreambuf<C,T>::buffer_size() const
+    {
+      return bufsz_;
+    }
+
+  /**
+   * Extracts characters up to, but not including, @a delim from the active
+   * input source. Unlike <b>std::getline</b>() nothing is copied: on
+   * success @a line points straight into the read buffer, and remains
+   * valid until the next extraction. The delimiter is consumed.
+   *
+   * If a line is longer than the buffer, the buffer is grown to fit it.
+   * A final line that isn't terminated by @a delim is still returned.
+   *
+   * @param   line    set to the first character of the line.
+   * @param   length  set to the number of characters in the line.
+   * @param   delim   the line terminator.
+   * @return  true if a line was extracted, false on end-of-file or error.
+   */
+  template <typename C, typename T>
+    bool
+    basic_pstreambuf<C,T>::read_line( const char_type*& line,
+                                      std::streamsize& length,
+                                      char_type delim )
+    {
+      if (!rbuffer())
+        return false;
+
+      // characters in [gptr(), egptr()) already known not to be delim
+      std::streamsize scanned = 0;
+
+      for (;;)
+      {
+        char_type* const begin = this->gptr();
+        char_type* const end = this->egptr();
+        const std::streamsize avail = begin ? end - begin : 0;
+
+        if (avail > scanned)
+        {
+          const char_type* found =
+            traits_type::find(begin + scanned, avail - scanned, delim);
+          if (found)
+          {
+            line = begin;
+            length = found - begin;
+            this->setg(this->eback(), begin + length + 1, end);
+            return true;
+          }
+          scanned = avail;
+        }
+
+        // need more input; move the partial line to the front of the
+        // buffer, growing the buffer if the partial line already fills it
+        char_type* rbuf = rbuffer();
+        std::size_t& capacity = rbufsz_[rsrc_];
+
+        if (std::size_t(pbsz + avail) == capacity)
+        {
+          char_type* grown = new char_type[capacity * 2];
+          traits_type::copy(grown + pbsz, begin, avail);
+          delete[] rbuf;
+          rbuf = rbuffer_[rsrc_] = grown;
+          capacity *= 2;
+        }
+        else if (avail && begin != rbuf + pbsz)
+          traits_type::move(rbuf + pbsz, begin, avail);
+
+        std::streamsize rc = -1;
+        if (wait_readable())
+        {
+          do
+          {
+            error_ = 0;
+            rc = read(rbuf + pbsz + avail, capacity - pbsz - avail);
+          } while (rc == -1 && error_ == EINTR);
+        }
+
+        if (rc <= 0)
+        {
+          this->setg(rbuf + pbsz, rbuf + pbsz + avail, rbuf + pbsz + avail);
+          if (avail)
+          {
+            line = rbuf + pbsz;
+            length = avail;
+            return true;
+          }
+          return false;
+        }
+
+        this->setg(rbuf + pbsz, rbuf + pbsz, rbuf + pbsz + avail + rc);
+      }
+    }
+
   /**
    *  @return  The exit status of the child process, or -1 if wait()
    *           has not yet been called to wait for the child to exit.
@@ -1900,7 +2482,7 @@ namespace redi
             ::fcntl(rpipe(), F_SETFL, flags | O_NONBLOCK);  // set non-blocking
 
           error_ = 0;
-          rc = read(rbuf + pbsz, bufsz - pbsz);
+          rc = read(rbuf + pbsz, rbufsz_[rsrc_] - pbsz);
 
           if (rc == -1 && error_ == EAGAIN)  // nothing available
             rc = 0;
@@ -1911,8 +2493,8 @@ namespace redi
             ::fcntl(rpipe(), F_SETFL, flags); // restore
         }
       }
-      else
-        rc = read(rbuf + pbsz, bufsz - pbsz);
+      else if (wait_readable())
+        rc = read(rbuf + pbsz, rbufsz_[rsrc_] - pbsz);
 
       if (rc > 0 || (rc == 0 && non_blocking))
       {
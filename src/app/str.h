@@ -0,0 +1,303 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2019 casey langen
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the author nor the names of other contributors may
+//      be used to endorse or promote products derived from this software
+//      without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace str {
+    /* a non-owning, read-only slice of a string; a minimal stand-in for
+    C++17's std::string_view. */
+    class view {
+        public:
+            static const size_t npos = (size_t) -1;
+
+            view() : ptr(nullptr), len(0) {
+            }
+
+            view(const char* data, size_t size) : ptr(data), len(size) {
+            }
+
+            view(const char* cstr) : ptr(cstr), len(strlen(cstr)) {
+            }
+
+            view(const std::string& str) : ptr(str.data()), len(str.size()) {
+            }
+
+            const char* data() const { return this->ptr; }
+            size_t size() const { return this->len; }
+            bool empty() const { return this->len == 0; }
+            const char* begin() const { return this->ptr; }
+            const char* end() const { return this->ptr + this->len; }
+            char operator[](size_t index) const { return this->ptr[index]; }
+
+            view substr(size_t pos, size_t count = npos) const {
+                pos = std::min(pos, this->len);
+                return view(this->ptr + pos, std::min(count, this->len - pos));
+            }
+
+            size_t find(char c, size_t pos = 0) const {
+                if (pos >= this->len) {
+                    return npos;
+                }
+                auto found = (const char*) memchr(this->ptr + pos, c, this->len - pos);
+                return found ? (size_t)(found - this->ptr) : npos;
+            }
+
+            size_t find(const view& needle, size_t pos = 0) const {
+                if (pos > this->len) {
+                    return npos;
+                }
+                auto found = std::search(this->begin() + pos, this->end(), needle.begin(), needle.end());
+                return (found == this->end() && !needle.empty()) ? npos : (size_t)(found - this->ptr);
+            }
+
+            view trim() const {
+                size_t front = 0, back = this->len;
+                while (front < back && isspace((unsigned char) this->ptr[front])) {
+                    ++front;
+                }
+                while (back > front && isspace((unsigned char) this->ptr[back - 1])) {
+                    --back;
+                }
+                return view(this->ptr + front, back - front);
+            }
+
+            bool startsWith(const view& prefix) const {
+                return prefix.len <= this->len &&
+                    memcmp(this->ptr, prefix.ptr, prefix.len) == 0;
+            }
+
+            bool operator==(const view& other) const {
+                return this->len == other.len &&
+                    memcmp(this->ptr, other.ptr, this->len) == 0;
+            }
+
+            bool operator!=(const view& other) const {
+                return !(*this == other);
+            }
+
+            std::string str() const {
+                return std::string(this->ptr, this->len);
+            }
+
+        private:
+            const char* ptr;
+            size_t len;
+    };
+
+    /* yields the trimmed, non-empty runs of `input` between any of the
+    `delimiters` as views into it; the allocation-free counterpart of split().
+
+        str::tokenizer tokens(line, " ");
+        for (str::view token; tokens.next(token);) { ... } */
+    class tokenizer {
+        public:
+            tokenizer(const view& input, const char* delimiters)
+            : input(input), delimiters(delimiters), pos(0) {
+            }
+
+            bool next(view& token) {
+                while (this->pos <= this->input.size()) {
+                    size_t end = this->pos;
+                    while (end < this->input.size() && !strchr(this->delimiters, this->input[end])) {
+                        ++end;
+                    }
+                    view candidate = this->input.substr(this->pos, end - this->pos).trim();
+                    this->pos = end + 1;
+                    if (!candidate.empty()) {
+                        token = candidate;
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+        private:
+            view input;
+            const char* delimiters;
+            size_t pos;
+    };
+
+    /* number parsing in the style of C++17's std::from_chars: no locale, no
+    exceptions, no allocation, no leading whitespace. returns a pointer past
+    the last character used, or `first` (leaving `value` alone) if there's no
+    number there. */
+    inline const char* fromChars(const char* first, const char* last, long& value) {
+        const char* p = first;
+        bool negative = false;
+        if (p != last && (*p == '-' || *p == '+')) {
+            negative = (*p++ == '-');
+        }
+        if (p == last || !isdigit((unsigned char) *p)) {
+            return first;
+        }
+        long result = 0;
+        for (; p != last && isdigit((unsigned char) *p); ++p) {
+            int digit = *p - '0';
+            if (result > (LONG_MAX - digit) / 10) {
+                return first; /* out of range */
+            }
+            result = result * 10 + digit;
+        }
+        value = negative ? -result : result;
+        return p;
+    }
+
+    inline const char* fromChars(const char* first, const char* last, int& value) {
+        long result;
+        const char* end = fromChars(first, last, result);
+        if (end == first || result < INT_MIN || result > INT_MAX) {
+            return first;
+        }
+        value = (int) result;
+        return end;
+    }
+
+    /* decimal notation with an optional exponent, e.g. "0.75", "-1", "2e-3" */
+    inline const char* fromChars(const char* first, const char* last, float& value) {
+        static const double POWERS[] = {
+            1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+        };
+        static const uint64_t MAX_MANTISSA = 100000000000000000ULL; /* 1e17 */
+
+        const char* p = first;
+        bool negative = false;
+        if (p != last && (*p == '-' || *p == '+')) {
+            negative = (*p++ == '-');
+        }
+
+        /* digits beyond what a double can hold only shift the exponent */
+        uint64_t mantissa = 0;
+        long exponent = 0;
+        int digits = 0;
+        for (; p != last && isdigit((unsigned char) *p); ++p, ++digits) {
+            if (mantissa < MAX_MANTISSA) {
+                mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+            }
+            else {
+                ++exponent;
+            }
+        }
+        if (p != last && *p == '.') {
+            for (++p; p != last && isdigit((unsigned char) *p); ++p, ++digits) {
+                if (mantissa < MAX_MANTISSA) {
+                    mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+                    --exponent;
+                }
+            }
+        }
+        if (digits == 0) {
+            return first;
+        }
+        if (p != last && (*p == 'e' || *p == 'E')) {
+            long e;
+            const char* end = fromChars(p + 1, last, e);
+            if (end != p + 1) {
+                exponent += std::max(-400L, std::min(e, 400L));
+                p = end;
+            }
+        }
+
+        double result = (double) mantissa;
+        for (; exponent < -22; exponent += 22) {
+            result /= POWERS[22];
+        }
+        for (; exponent > 22; exponent -= 22) {
+            result *= POWERS[22];
+        }
+        result = (exponent < 0) ? result / POWERS[-exponent] : result * POWERS[exponent];
+
+        value = (float)(negative ? -result : result);
+        return p;
+    }
+
+    /* true if the entire view is a number */
+    template <typename T>
+    inline bool parse(const view& input, T& value) {
+        return !input.empty() && fromChars(input.begin(), input.end(), value) == input.end();
+    }
+
+    inline std::string trim(const std::string &s) {
+        /* so lazy https://stackoverflow.com/a/17976541 */
+        auto front = std::find_if_not(s.begin(), s.end(), isspace);
+        auto back = std::find_if_not(s.rbegin(), s.rend(), isspace).base();
+        return (back <= front ? std::string() : std::string(front, back));
+    }
+
+    inline std::vector<std::string> split(const std::string& str, const std::string& delimiters) {
+        using ContainerT = std::vector<std::string>;
+        ContainerT tokens;
+        std::string::size_type pos, lastPos = 0, length = str.length();
+        using value_type = ContainerT::value_type;
+        using size_type = ContainerT::size_type;
+        while (lastPos < length + 1) {
+            pos = str.find_first_of(delimiters, lastPos);
+            if (pos == std::string::npos) {
+                pos = length;
+            }
+            if (pos != lastPos) {
+                std::string token = trim(value_type(
+                    str.data() + lastPos, (size_type) pos - lastPos));
+                if (token.size()) {
+                    tokens.push_back(token);
+                }
+            }
+            lastPos = pos + 1;
+        }
+        return tokens;
+    }
+
+    inline int parseIndex(const view& value) {
+        int index;
+        return parse(value, index) ? index : -1;
+    }
+
+    template<typename... Args>
+    static std::string fmt(const std::string& format, Args ... args) {
+        size_t size = std::snprintf(nullptr, 0, format.c_str(), args ...) + 1; /* extra space for '\0' */
+        std::unique_ptr<char[]> buf(new char[size]);
+        std::snprintf(buf.get(), size, format.c_str(), args ...);
+        return std::string(buf.get(), buf.get() + size - 1); /* omit the '\0' */
+    }
+}
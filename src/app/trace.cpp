@@ -0,0 +1,123 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2019 casey langen
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the author nor the names of other contributors may
+//      be used to endorse or promote products derived from this software
+//      without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include "trace.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace trace {
+    bool enabled = false;
+
+    static std::mutex lock;
+    static FILE* out = nullptr;
+    static bool first = true;
+    static Sink sink;
+
+    static void finish() {
+        std::unique_lock<std::mutex> guard(lock);
+        if (out) {
+            fputs("\n]\n", out);
+            fclose(out);
+            out = nullptr;
+        }
+    }
+
+    bool open(const std::string& path) {
+        std::unique_lock<std::mutex> guard(lock);
+        if (out) {
+            return false;
+        }
+        out = fopen(path.c_str(), "we");
+        if (!out) {
+            return false;
+        }
+        fputs("[\n", out);
+        atexit(finish);
+        enabled = true;
+        return true;
+    }
+
+    void route(Sink to) {
+        std::unique_lock<std::mutex> guard(lock);
+        sink = to;
+        enabled = true;
+    }
+
+    uint64_t now() {
+        using namespace std::chrono;
+        return (uint64_t) duration_cast<microseconds>(
+            steady_clock::now().time_since_epoch()).count();
+    }
+
+    void record(
+        const char* category,
+        const char* name,
+        uint64_t startUs,
+        uint64_t endUs,
+        const char* arg,
+        long value)
+    {
+        static const long pid = (long) getpid();
+        static thread_local long tid = (long) syscall(SYS_gettid);
+
+        std::unique_lock<std::mutex> guard(lock);
+
+        if (out) {
+            fprintf(
+                out,
+                "%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%llu,\"dur\":%llu,\"pid\":%ld,\"tid\":%ld",
+                first ? "" : ",\n",
+                name,
+                category,
+                (unsigned long long) startUs,
+                (unsigned long long) (endUs - startUs),
+                pid,
+                tid);
+            if (arg) {
+                fprintf(out, ",\"args\":{\"%s\":%ld}", arg, value);
+            }
+            fputc('}', out);
+            first = false;
+        }
+
+        if (sink) {
+            sink(category, name, (double) (endUs - startUs) / 1000.0);
+        }
+    }
+}
@@ -0,0 +1,111 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2019 casey langen
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the author nor the names of other contributors may
+//      be used to endorse or promote products derived from this software
+//      without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+/* spans for each stage of the hot path (process spawn, first byte, EOF,
+waitpid, parsing, X round trips, model updates, redraws), for when "it
+lags" needs numbers. nothing is recorded unless open() or route() was
+called; until then a span costs a single, well predicted, branch.
+
+    {
+        trace::Span span("xrandr", "spawn");
+        ...
+    } */
+namespace trace {
+    /* set once at startup, before any other thread exists; don't write */
+    extern bool enabled;
+
+    using Sink = std::function<void(const char* category, const char* name, double ms)>;
+
+    /* writes every span recorded from now on to `path`, in the Chrome trace
+    event format (load it in chrome://tracing or ui.perfetto.dev). the file
+    is completed when the process exits. */
+    bool open(const std::string& path);
+
+    /* hands every span to `sink` as it ends, e.g. to log it. may be called
+    from any thread. */
+    void route(Sink sink);
+
+    /* microseconds on the steady clock */
+    uint64_t now();
+
+    /* `category` and `name` must be string literals, or otherwise outlive
+    the process; they're written out verbatim. */
+    void record(
+        const char* category,
+        const char* name,
+        uint64_t startUs,
+        uint64_t endUs,
+        const char* arg = nullptr,
+        long value = 0);
+
+    class Span {
+        public:
+            Span(const char* category, const char* name)
+            : category(category), name(name), start(enabled ? now() : 0) {
+            }
+
+            ~Span() {
+                if (enabled) {
+                    this->End();
+                }
+            }
+
+            /* attached to the span when it's recorded; one per span */
+            void Arg(const char* name, long value) {
+                this->arg = name;
+                this->value = value;
+            }
+
+            /* records the span now, rather than when it goes out of scope */
+            void End() {
+                if (this->start) {
+                    record(this->category, this->name, this->start, now(), this->arg, this->value);
+                    this->start = 0;
+                }
+            }
+
+        private:
+            const char* category;
+            const char* name;
+            uint64_t start;
+            const char* arg = nullptr;
+            long value = 0;
+    };
+}
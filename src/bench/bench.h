@@ -0,0 +1,131 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2019 casey langen
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the author nor the names of other contributors may
+//      be used to endorse or promote products derived from this software
+//      without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace bench {
+    using Clock = std::chrono::steady_clock;
+
+    inline double elapsedMs(Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    class Samples {
+        public:
+            void Add(double ms) {
+                this->values.push_back(ms);
+                this->sorted = false;
+            }
+
+            size_t Count() const {
+                return this->values.size();
+            }
+
+            double Percentile(double p) {
+                if (this->values.empty()) {
+                    return 0.0;
+                }
+                if (!this->sorted) {
+                    std::sort(this->values.begin(), this->values.end());
+                    this->sorted = true;
+                }
+                size_t index = (size_t)(p / 100.0 * (double)(this->values.size() - 1) + 0.5);
+                return this->values[std::min(index, this->values.size() - 1)];
+            }
+
+            double Mean() const {
+                double total = 0.0;
+                for (double v : this->values) {
+                    total += v;
+                }
+                return this->values.empty() ? 0.0 : total / this->values.size();
+            }
+
+        private:
+            std::vector<double> values;
+            bool sorted = false;
+    };
+
+    inline void report(const std::string& name, Samples& samples) {
+        printf(
+            "  %-40s n=%-6zu p50=%9.3fms  p99=%9.3fms  mean=%9.3fms\n",
+            name.c_str(),
+            samples.Count(),
+            samples.Percentile(50.0),
+            samples.Percentile(99.0),
+            samples.Mean());
+    }
+
+    struct Options {
+        int iterations = 100;
+    };
+
+    /* calls to operator new so far, by any thread; the replacement that
+    counts them lives in parse.cpp */
+    size_t allocationCount();
+
+    /* `xrandr --verbose` output for `outputs` outputs, named DP-0 and up */
+    std::string xrandrVerbose(int outputs);
+
+    /* behaves like xrandr, when the bench is run as `xrandr` (via a symlink
+    on PATH). configured through the environment:
+
+      XDIMMER_FAKE_OUTPUTS     outputs to report (default 4)
+      XDIMMER_FAKE_SCRIPT      file to print instead of generated output
+      XDIMMER_FAKE_LATENCY_MS  delay before doing anything
+      XDIMMER_FAKE_OUTPUT_MS   further delay per output queried or written
+      XDIMMER_FAKE_LOG         file to append one byte to per process
+      XDIMMER_FAKE_EXEC        real xrandr to exec once logged */
+    int fakeXrandr(int argc, char* argv[]);
+
+    namespace suites {
+        void spawn(const Options& options);
+        void readline(const Options& options);
+        void daemon(const Options& options);
+        void fade(const Options& options);
+        void gamma(const Options& options);
+        void parse(const Options& options);
+        void latency(const Options& options);
+        void render(const Options& options);
+        void startup(const Options& options);
+        void produce(size_t bytes); /* child side of `readline` */
+    }
+}
@@ -0,0 +1,123 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2019 casey langen
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the author nor the names of other contributors may
+//      be used to endorse or promote products derived from this software
+//      without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include "bench.h"
+
+#include <app/ipc.h>
+
+#include <atomic>
+#include <thread>
+
+/* load test for `xdimmer --daemon`, which needs to be running already:
+round trip latency of single requests, then throughput with 1-16
+concurrent clients, each either waiting for every response or pipelining
+PIPELINE_DEPTH requests at a time. only reads and no-op writes are issued,
+so nothing on screen changes. */
+
+namespace bench { namespace suites {
+    static const int PIPELINE_DEPTH = 64;
+    static const int CLIENTS[] = { 1, 4, 16 };
+
+    static void latency(const std::string& name, const std::string& request, const Options& options) {
+        ipc::Client client;
+        std::string response;
+        Samples samples;
+        for (int i = 0; i < options.iterations; i++) {
+            auto start = Clock::now();
+            if (!client.Call(request, response) || response[0] != '+') {
+                printf("  %s failed: %s\n", request.c_str(), response.c_str());
+                return;
+            }
+            samples.Add(elapsedMs(start));
+        }
+        report(name, samples);
+    }
+
+    static void throughput(int clients, int depth, const Options& options) {
+        std::atomic<long> completed(0);
+        std::vector<std::thread> threads;
+        auto start = Clock::now();
+
+        for (int c = 0; c < clients; c++) {
+            threads.emplace_back([&]() {
+                ipc::Client client;
+                std::string response;
+                if (!client.Connect()) {
+                    return;
+                }
+                for (int i = 0; i < options.iterations; i++) {
+                    for (int r = 0; r < depth; r++) {
+                        client.Queue("g 0");
+                    }
+                    if (!client.Flush()) {
+                        return;
+                    }
+                    for (int r = 0; r < depth; r++) {
+                        if (!client.Receive(response)) {
+                            return;
+                        }
+                    }
+                    completed += depth;
+                }
+            });
+        }
+
+        for (auto& t : threads) {
+            t.join();
+        }
+
+        double seconds = elapsedMs(start) / 1000.0;
+        std::string name =
+            std::to_string(clients) + " client(s), " +
+            std::to_string(depth) + " request(s) in flight";
+        printf("  %-40s %.0f requests/s\n", name.c_str(), (double) completed / seconds);
+    }
+
+    void daemon(const Options& options) {
+        ipc::Client probe;
+        std::string value;
+        if (!probe.Call("g 0", value) || value[0] != '+') {
+            printf("  no daemon on %s; start `xdimmer --daemon` first\n", ipc::path().c_str());
+            return;
+        }
+
+        latency("get, round trip", "g 0", options);
+        latency("set to current value, round trip", "s 0 " + value.substr(1), options);
+
+        for (int clients : CLIENTS) {
+            throughput(clients, 1, options);
+            throughput(clients, PIPELINE_DEPTH, options);
+        }
+    }
+} }
@@ -0,0 +1,103 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2019 casey langen
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the author nor the names of other contributors may
+//      be used to endorse or promote products derived from this software
+//      without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include "bench.h"
+
+#include <app/Transition.h>
+
+#include <sys/resource.h>
+
+/* the cpu cost of driving a fade with cmd::Transition: timer wakeups plus
+computing each frame's values, for a number of outputs and refresh rates.
+the backend's cost of applying a frame (building and uploading gamma ramps,
+or spawning xrandr) comes on top of this and isn't measured here. */
+
+namespace bench { namespace suites {
+    static const int FADE_MS = 500;
+
+    static double cpuMs() {
+        rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return
+            usage.ru_utime.tv_sec * 1000.0 + usage.ru_utime.tv_usec / 1000.0 +
+            usage.ru_stime.tv_sec * 1000.0 + usage.ru_stime.tv_usec / 1000.0;
+    }
+
+    static void run(int outputs, float refresh, const Options& options) {
+        std::vector<cmd::Write> targets;
+        for (int i = 0; i < outputs; i++) {
+            Monitor m;
+            m.name = "OUT-" + std::to_string(i);
+            m.brightness = 1.0f;
+            m.refresh = refresh;
+            targets.push_back({ m, 0.3f });
+        }
+
+        /* each fade takes FADE_MS of wall time, so don't run too many */
+        int iterations = std::max(1, std::min(options.iterations, 10));
+        Samples samples;
+        size_t frames = 0;
+        double cpu = 0.0;
+        for (int i = 0; i < iterations; i++) {
+            cmd::Transition transition;
+            double before = cpuMs();
+            auto start = Clock::now();
+            transition.Start(targets, FADE_MS, cmd::Easing::InOut);
+            while (transition.Active()) {
+                transition.Wait();
+                frames += transition.Frame().size() / targets.size();
+            }
+            samples.Add(elapsedMs(start));
+            cpu += cpuMs() - before;
+        }
+
+        std::string name =
+            std::to_string(outputs) + " output(s) at " +
+            std::to_string((int) refresh) + "Hz, " + std::to_string(FADE_MS) + "ms";
+
+        report(name, samples);
+        printf(
+            "  %-40s %.2fms cpu per fade, %zu frames\n",
+            "",
+            cpu / iterations,
+            frames / iterations);
+    }
+
+    void fade(const Options& options) {
+        run(1, 60.0f, options);
+        run(1, 144.0f, options);
+        run(4, 60.0f, options);
+        run(16, 144.0f, options);
+    }
+} }
@@ -0,0 +1,113 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2019 casey langen
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the author nor the names of other contributors may
+//      be used to endorse or promote products derived from this software
+//      without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include "bench.h"
+
+#include <app/GammaTable.h>
+
+#include <cmath>
+
+/* gamma ramps generated per second on one core, for the ramp sizes drivers
+commonly report: calling pow() for every entry (what the native backend
+used to do), scaling a cached curve with the scalar and SIMD kernels, and
+GammaTable lookups, both when every brightness is new and when the same
+short fade keeps being replayed. */
+
+namespace bench { namespace suites {
+    static const int SIZES[] = { 256, 1024, 4096 };
+    static const double EXPONENT = 1.0 / 2.2;
+    static const int RAMPS_PER_ITERATION = 100;
+
+    static volatile uint16_t sink;
+
+    /* `steps` distinct brightness values, cycled through */
+    static void run(const std::string& name, const Options& options, int steps, std::function<void(float)> build) {
+        const int count = options.iterations * RAMPS_PER_ITERATION;
+        auto start = Clock::now();
+        for (int i = 0; i < count; i++) {
+            build(0.3f + 0.7f * (float)(i % steps) / (float) steps);
+        }
+        double seconds = elapsedMs(start) / 1000.0;
+        printf("  %-40s %12.0f ramps/s\n", name.c_str(), count / seconds);
+    }
+
+    void gamma(const Options& options) {
+        for (int size : SIZES) {
+            std::vector<float> curve(size);
+            for (int i = 0; i < size; i++) {
+                curve[i] = (float) std::pow((double) i / (size - 1), EXPONENT);
+            }
+            std::vector<uint16_t> out(size), check(size);
+
+            size_t mismatched = 0;
+            for (int b = 0; b <= 1000; b++) {
+                cmd::scaleRamp(curve.data(), size, b / 1000.0f, out.data());
+                cmd::scaleRampScalar(curve.data(), size, b / 1000.0f, check.data());
+                mismatched += (out != check);
+            }
+            printf("  %d entries (%zu kernel mismatches)\n", size, mismatched);
+
+            run("pow() per entry", options, 1000, [&](float brightness) {
+                const double last = (double)(size - 1);
+                for (int i = 0; i < size; i++) {
+                    double value = std::min(std::pow(i / last, EXPONENT) * brightness, 1.0);
+                    out[i] = (uint16_t)(value * 65535.0);
+                }
+                sink = out[size / 2];
+            });
+
+            run("cached curve, scalar kernel", options, 1000, [&](float brightness) {
+                cmd::scaleRampScalar(curve.data(), size, brightness, out.data());
+                sink = out[size / 2];
+            });
+
+            run("cached curve, SIMD kernel", options, 1000, [&](float brightness) {
+                cmd::scaleRamp(curve.data(), size, brightness, out.data());
+                sink = out[size / 2];
+            });
+
+            for (int steps : { 1000, 30 }) {
+                cmd::GammaTable table;
+                run("GammaTable, " + std::to_string(steps) + " brightness values", options, steps, [&](float brightness) {
+                    sink = table.Ramp(size, EXPONENT, brightness)[size / 2];
+                });
+                printf(
+                    "  %-40s %zu hits, %zu misses\n",
+                    "",
+                    table.Hits(),
+                    table.Misses());
+            }
+        }
+    }
+} }
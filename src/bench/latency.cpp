@@ -0,0 +1,362 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2019 casey langen
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the author nor the names of other contributors may
+//      be used to endorse or promote products derived from this software
+//      without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include "bench.h"
+
+#include <app/cmd.h>
+#include <app/DeviceCache.h>
+#include <app/Engine.h>
+
+#include <climits>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+
+/* latency of the cmd:: layer, and how many xrandr processes each call costs,
+against the stand-in xrandr (see fakeXrandr()) with 1 to 16 outputs and a few
+latency profiles. if XDIMMER_FAKE_SCRIPT is set, the stand-in prints that
+file instead. the cmd:: backend is picked once per process, so if Xvfb is
+installed the suite then runs itself again against a fresh Xvfb server, with
+whichever backend it would use for real. */
+
+namespace bench { namespace suites {
+    struct Profile {
+        const char* name;
+        int startupMs;
+        int outputMs;
+    };
+
+    static const Profile PROFILES[] = {
+        { "instant", 0, 0 },
+        { "10ms + 5ms/output", 10, 5 },
+    };
+
+    static const int OUTPUTS[] = { 1, 4, 16 };
+
+    static const int FADE_MS = 150; /* the TUI's default */
+
+    static std::string which(const char* name) {
+        const char* env = getenv("PATH");
+        std::string path = env ? env : "/usr/bin:/bin";
+        size_t start = 0;
+        while (start <= path.size()) {
+            size_t end = path.find(':', start);
+            end = (end == std::string::npos) ? path.size() : end;
+            std::string candidate = path.substr(start, end - start) + "/" + name;
+            if (::access(candidate.c_str(), X_OK) == 0) {
+                return candidate;
+            }
+            start = end + 1;
+        }
+        return "";
+    }
+
+    static size_t spawned(const std::string& log) {
+        struct stat st;
+        return ::stat(log.c_str(), &st) == 0 ? (size_t) st.st_size : 0;
+    }
+
+    static void measure(
+        const std::string& name,
+        const Options& options,
+        const std::string& log,
+        std::function<void(int)> call)
+    {
+        Samples samples;
+        size_t before = spawned(log);
+        for (int i = 0; i < options.iterations; i++) {
+            auto start = Clock::now();
+            call(i);
+            samples.Add(elapsedMs(start));
+        }
+        report(name, samples);
+        if (!log.empty()) {
+            printf(
+                "  %-40s %.2f processes per call\n",
+                "",
+                (double) (spawned(log) - before) / options.iterations);
+        }
+    }
+
+    /* blocks until the engine delivers the results of a query */
+    class Completion {
+        public:
+            void Signal() {
+                std::unique_lock<std::mutex> lock(this->lock);
+                this->done = true;
+                this->cv.notify_all();
+            }
+
+            void Wait() {
+                std::unique_lock<std::mutex> lock(this->lock);
+                this->cv.wait(lock, [this]() { return this->done; });
+                this->done = false;
+            }
+
+        private:
+            std::mutex lock;
+            std::condition_variable cv;
+            bool done = false;
+    };
+
+    static void run(const std::string& label, const Options& options, const std::string& log) {
+        auto all = ::cmd::query();
+        printf("  %s, %zu output(s)\n", label.c_str(), all.size());
+        if (all.empty()) {
+            return;
+        }
+
+        /* alternate between two values, neither of which the outputs start
+        at, so no write is skipped as redundant */
+        auto value = [](int i) {
+            return (i % 2) ? 0.31f : 0.32f;
+        };
+
+        const std::string last = std::to_string(all.size() - 1);
+
+        measure("query()", options, log, [](int) {
+            ::cmd::query();
+        });
+
+        measure("query(\"0\")", options, log, [](int) {
+            ::cmd::query("0");
+        });
+
+        if (all.size() > 1) {
+            measure("query(\"" + last + "\")", options, log, [&last](int) {
+                ::cmd::query(last);
+            });
+        }
+
+        /* the CLI's path. only backends that can vouch for the cached list
+        cheaply (see Backend::Configuration()) use it; with the stand-in,
+        both of these are plain queries. */
+        const std::string cache = ::cmd::DeviceCache::DefaultPath();
+        ::cmd::useDeviceCache(true);
+
+        measure("resolve(\"" + last + "\"), cold cache", options, log, [&](int) {
+            unlink(cache.c_str());
+            ::cmd::resolve(last);
+        });
+
+        measure("resolve(\"" + last + "\"), warm cache", options, log, [&](int) {
+            ::cmd::resolve(last);
+        });
+
+        ::cmd::useDeviceCache(false);
+        unlink(cache.c_str());
+
+        measure("update(), all outputs", options, log, [&](int i) {
+            std::vector<::cmd::Write> writes;
+            for (auto& m : all) {
+                writes.push_back({ m, value(i) });
+            }
+            ::cmd::update(writes);
+        });
+
+        Completion completion;
+        ::cmd::Engine engine([&completion](const ::cmd::Engine::Result&) {
+            completion.Signal();
+        });
+
+        measure("tui refresh", options, log, [&](int) {
+            engine.Refresh();
+            completion.Wait();
+        });
+
+        /* what the TUI does for a global adjustment, until a refresh shows
+        the result; the fade dominates, but the process count is the point */
+        measure("tui UpdateAll + refresh", options, log, [&](int i) {
+            std::vector<::cmd::Write> writes;
+            for (auto& m : all) {
+                writes.push_back({ m, value(i) });
+            }
+            engine.Fade(writes, FADE_MS, ::cmd::Easing::InOut);
+            engine.Refresh();
+            completion.Wait();
+        });
+    }
+
+    static void xvfb(const Options& options, const std::string& self) {
+        std::string server = which("Xvfb");
+        if (server.empty()) {
+            printf("  Xvfb not found; skipped\n");
+            return;
+        }
+
+        int fds[2];
+        if (::pipe(fds) != 0) {
+            return;
+        }
+
+        std::string displayFd = std::to_string(fds[1]);
+        const char* serverArgs[] = {
+            "Xvfb", "-displayfd", displayFd.c_str(), "-nolisten", "tcp",
+            "-screen", "0", "1920x1080x24", nullptr
+        };
+
+        pid_t serverPid;
+        if (posix_spawn(&serverPid, server.c_str(), nullptr, nullptr, (char**) serverArgs, environ) != 0) {
+            close(fds[0]);
+            close(fds[1]);
+            printf("  couldn't start Xvfb; skipped\n");
+            return;
+        }
+
+        close(fds[1]);
+
+        /* Xvfb writes the display number it picked once it's accepting
+        connections */
+        char number[16] = { 0 };
+        ssize_t count = ::read(fds[0], number, sizeof(number) - 1);
+        close(fds[0]);
+
+        if (count > 0) {
+            std::string display = ":" + std::to_string(atoi(number));
+            std::string iterations = std::to_string(options.iterations);
+            setenv("DISPLAY", display.c_str(), 1);
+            setenv("XDIMMER_BENCH_XVFB", "1", 1);
+
+            const char* benchArgs[] = {
+                "xdimmer_bench", "--iterations", iterations.c_str(), "latency", nullptr
+            };
+
+            pid_t benchPid;
+            if (posix_spawn(&benchPid, self.c_str(), nullptr, nullptr, (char**) benchArgs, environ) == 0) {
+                waitpid(benchPid, nullptr, 0);
+            }
+        }
+
+        kill(serverPid, SIGTERM);
+        waitpid(serverPid, nullptr, 0);
+    }
+
+    void latency(const Options& options) {
+        char self[PATH_MAX] = { 0 };
+        if (readlink("/proc/self/exe", self, sizeof(self) - 1) <= 0) {
+            return;
+        }
+
+        /* the second half of xvfb(); the environment is already set up */
+        if (getenv("XDIMMER_BENCH_XVFB")) {
+            const char* log = getenv("XDIMMER_FAKE_LOG");
+            run(std::string("xvfb ") + getenv("DISPLAY"), options, log ? log : "");
+            return;
+        }
+
+        const std::string realXrandr = which("xrandr");
+
+        char dir[] = "/tmp/xdimmer-bench-XXXXXX";
+        if (!mkdtemp(dir)) {
+            return;
+        }
+
+        /* xrandr on PATH is this binary, which acts as the stand-in when
+        it's run by that name */
+        const std::string shim = std::string(dir) + "/xrandr";
+        const std::string log = std::string(dir) + "/spawned";
+        if (symlink(self, shim.c_str()) != 0) {
+            rmdir(dir);
+            return;
+        }
+
+        const char* env = getenv("PATH");
+        const std::string path = env ? env : "/usr/bin:/bin";
+        setenv("PATH", (std::string(dir) + ":" + path).c_str(), 1);
+        setenv("XDIMMER_FAKE_LOG", log.c_str(), 1);
+
+        /* keeps the device cache away from the real one */
+        env = getenv("XDG_RUNTIME_DIR");
+        const std::string runtime = env ? env : "";
+        setenv("XDG_RUNTIME_DIR", dir, 1);
+
+        /* otherwise the libXrandr backend would talk to the real display,
+        and the stand-in would never run */
+        env = getenv("DISPLAY");
+        const std::string display = env ? env : "";
+        unsetenv("DISPLAY");
+
+        const bool scripted = getenv("XDIMMER_FAKE_SCRIPT") != nullptr;
+
+        for (auto& profile : PROFILES) {
+            setenv("XDIMMER_FAKE_LATENCY_MS", std::to_string(profile.startupMs).c_str(), 1);
+            setenv("XDIMMER_FAKE_OUTPUT_MS", std::to_string(profile.outputMs).c_str(), 1);
+
+            if (scripted) {
+                run(std::string("stand-in, scripted, ") + profile.name, options, log);
+                continue;
+            }
+
+            for (int outputs : OUTPUTS) {
+                setenv("XDIMMER_FAKE_OUTPUTS", std::to_string(outputs).c_str(), 1);
+                run(std::string("stand-in, ") + profile.name, options, log);
+            }
+        }
+
+        /* with a real xrandr behind the shim, so its processes are counted
+        too, if it ends up being used */
+        if (!realXrandr.empty()) {
+            setenv("XDIMMER_FAKE_EXEC", realXrandr.c_str(), 1);
+        }
+        else {
+            setenv("PATH", path.c_str(), 1);
+            unsetenv("XDIMMER_FAKE_LOG");
+        }
+
+        xvfb(options, self);
+
+        if (!display.empty()) {
+            setenv("DISPLAY", display.c_str(), 1);
+        }
+
+        if (!runtime.empty()) {
+            setenv("XDG_RUNTIME_DIR", runtime.c_str(), 1);
+        }
+        else {
+            unsetenv("XDG_RUNTIME_DIR");
+        }
+
+        unlink(log.c_str());
+        unlink(shim.c_str());
+        rmdir(dir);
+    }
+} }
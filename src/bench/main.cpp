@@ -0,0 +1,104 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2019 casey langen
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the author nor the names of other contributors may
+//      be used to endorse or promote products derived from this software
+//      without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include "bench.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <map>
+
+using namespace bench;
+
+using Suite = std::function<void(const Options&)>;
+
+static const std::map<std::string, Suite> SUITES = {
+    { "spawn", suites::spawn },
+    { "readline", suites::readline },
+    { "daemon", suites::daemon },
+    { "fade", suites::fade },
+    { "gamma", suites::gamma },
+    { "parse", suites::parse },
+    { "latency", suites::latency },
+    { "render", suites::render },
+    { "startup", suites::startup },
+};
+
+static void usage() {
+    printf("usage: xdimmer_bench [--iterations N] [suite ...]\n\nsuites:\n");
+    for (auto& it : SUITES) {
+        printf("  %s\n", it.first.c_str());
+    }
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    std::vector<std::string> selected;
+
+    const char* invoked = strrchr(argv[0], '/');
+    if (!strcmp(invoked ? invoked + 1 : argv[0], "xrandr")) {
+        return fakeXrandr(argc, argv);
+    }
+
+    if (argc == 3 && !strcmp(argv[1], "--produce")) {
+        suites::produce((size_t) atol(argv[2]));
+        return 0;
+    }
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--iterations") && i + 1 < argc) {
+            options.iterations = std::max(1, atoi(argv[++i]));
+        }
+        else if (SUITES.find(argv[i]) != SUITES.end()) {
+            selected.push_back(argv[i]);
+        }
+        else {
+            usage();
+            return 1;
+        }
+    }
+
+    if (selected.empty()) {
+        for (auto& it : SUITES) {
+            selected.push_back(it.first);
+        }
+    }
+
+    for (auto& name : selected) {
+        printf("%s\n", name.c_str());
+        SUITES.find(name)->second(options);
+    }
+
+    return 0;
+}
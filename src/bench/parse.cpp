@@ -0,0 +1,104 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2019 casey langen
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the author nor the names of other contributors may
+//      be used to endorse or promote products derived from this software
+//      without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include "bench.h"
+
+#include <app/VerboseParser.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+/* throughput and heap allocations of cmd::VerboseParser over synthetic
+`xrandr --verbose` dumps with 1 to 64 outputs; see xrandrVerbose(). */
+
+static std::atomic<size_t> allocations(0);
+
+void* operator new(size_t size) {
+    ++allocations;
+    void* p = malloc(size ? size : 1);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+size_t bench::allocationCount() {
+    return allocations;
+}
+
+namespace bench { namespace suites {
+    static const int OUTPUTS[] = { 1, 4, 16, 64 };
+
+    void parse(const Options& options) {
+        for (int outputs : OUTPUTS) {
+            const std::string input = xrandrVerbose(outputs);
+            const int iterations = options.iterations * 10;
+
+            Samples samples;
+            size_t allocated = 0, parsed = 0;
+            for (int i = 0; i < iterations; i++) {
+                size_t before = allocations;
+                auto start = Clock::now();
+                {
+                    cmd::VerboseParser parser;
+                    str::view rest(input);
+                    for (size_t end; (end = rest.find('\n')) != str::view::npos;) {
+                        parser.Feed(rest.substr(0, end));
+                        rest = rest.substr(end + 1);
+                    }
+                    parsed = parser.Monitors().size();
+                }
+                samples.Add(elapsedMs(start));
+                allocated += allocations - before;
+            }
+
+            std::string name =
+                std::to_string(outputs) + " output(s), " +
+                std::to_string(input.size() / 1024) + "KB";
+
+            report(name, samples);
+            printf(
+                "  %-40s %.0f MB/s, %.1f allocations per parse (%zu outputs)\n",
+                "",
+                ((double) input.size() / (1024.0 * 1024.0)) / (samples.Mean() / 1000.0),
+                (double) allocated / iterations,
+                parsed);
+        }
+    }
+} }
@@ -0,0 +1,138 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2019 casey langen
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the author nor the names of other contributors may
+//      be used to endorse or promote products derived from this software
+//      without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include "bench.h"
+
+#include <app/LineReader.h>
+
+#include <fstream>
+#include <unistd.h>
+
+/* reads ~1MB of line-oriented output from a child process three ways, and
+reports throughput and the number of read(2) calls it took: std::getline()
+with pstreams' default 32 byte buffer, std::getline() with a large buffer,
+and cmd::LineReader, which hands out views into the read buffer. */
+
+namespace bench { namespace suites {
+    static const size_t PRODUCE_BYTES = 1024 * 1024;
+    static const size_t BUFFER_SIZE = 64 * 1024;
+
+    /* read syscalls made by this process so far; linux only. */
+    static long readSyscalls() {
+        std::ifstream io("/proc/self/io");
+        std::string key;
+        long value;
+        while (io >> key >> value) {
+            if (key == "syscr:") {
+                return value;
+            }
+        }
+        return -1;
+    }
+
+    static redi::pstreams::argv_type producer() {
+        return { "xdimmer_bench", "--produce", std::to_string(PRODUCE_BYTES) };
+    }
+
+    static void run(const std::string& name, const Options& options, std::function<size_t()> read) {
+        Samples samples;
+        long syscalls = 0;
+        size_t bytes = 0;
+        for (int i = 0; i < options.iterations; i++) {
+            long before = readSyscalls();
+            auto start = Clock::now();
+            bytes = read();
+            samples.Add(elapsedMs(start));
+            syscalls += readSyscalls() - before;
+        }
+        report(name, samples);
+        printf(
+            "  %-40s %.0f MB/s, %ld read(2) calls per %zu bytes\n",
+            "",
+            ((double) bytes / (1024.0 * 1024.0)) / (samples.Percentile(50.0) / 1000.0),
+            syscalls / options.iterations,
+            bytes);
+    }
+
+    void readline(const Options& options) {
+        const std::string self = "/proc/self/exe";
+
+        run("std::getline, 32 byte buffer", options, [&]() {
+            size_t bytes = 0;
+            redi::ipstream in(self, producer());
+            for (std::string line; std::getline(in, line);) {
+                bytes += line.size() + 1;
+            }
+            return bytes;
+        });
+
+        run("std::getline, 64KB buffer", options, [&]() {
+            size_t bytes = 0;
+            redi::ipstream in;
+            in.rdbuf()->buffer_size(BUFFER_SIZE);
+            in.open(self, producer());
+            for (std::string line; std::getline(in, line);) {
+                bytes += line.size() + 1;
+            }
+            return bytes;
+        });
+
+        cmd::LineReader reader(BUFFER_SIZE);
+        run("cmd::LineReader, 64KB buffer", options, [&]() {
+            size_t bytes = 0;
+            for (auto line : reader.Open(self, producer())) {
+                bytes += line.size() + 1;
+            }
+            reader.Close();
+            return bytes;
+        });
+    }
+
+    /* invoked in the child: writes `bytes` worth of xrandr-ish lines */
+    void produce(size_t bytes) {
+        static const char LINE[] =
+            "\t\t00ffffffffffff0006af3d5700000000001b0104a51f117802f4f5a4544d9c27\n";
+        std::string chunk;
+        while (chunk.size() < BUFFER_SIZE) {
+            chunk += LINE;
+        }
+        while (bytes > 0) {
+            size_t count = std::min(bytes, chunk.size());
+            if (::write(STDOUT_FILENO, chunk.data(), count) <= 0) {
+                return;
+            }
+            bytes -= count;
+        }
+    }
+} }
@@ -0,0 +1,234 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2019 casey langen
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the author nor the names of other contributors may
+//      be used to endorse or promote products derived from this software
+//      without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include "bench.h"
+
+#include <app/RowCache.h>
+
+#include <cmath>
+#include <fcntl.h>
+#include <thread>
+#include <unistd.h>
+
+/* cost of producing the list's rows for a frame and writing them to a
+pseudo-terminal, with 64 and 256 outputs: formatting every row from scratch
+the way ui::formatRow used to (rescanning every name per row, and growing
+the track a glyph at a time), and ui::RowCache when nothing changed, when
+one output changed (a key press), and when every output changed (a fade).
+cursespp isn't linked, so what the list window does with the text isn't
+included; it used to get a new SingleLineEntry per row per frame, now only
+per changed row. */
+
+namespace bench { namespace suites {
+    static const size_t OUTPUTS[] = { 64, 256 };
+    static const size_t WIDTH = 120;
+    static const int FRAMES_PER_ITERATION = 10;
+
+    static std::string align(const std::string& value, size_t width) {
+        return (value.size() < width) ? std::string(width - value.size(), ' ') + value : value;
+    }
+
+    /* what ui::formatRow did before RowCache, less cursespp */
+    static std::string formatRow(size_t width, const std::vector<Monitor>& monitors, size_t index) {
+        auto& m = monitors[index];
+
+        size_t maxLeft = 0;
+        for (auto& m: monitors) {
+            if (m.name.size() > maxLeft) {
+                maxLeft = m.name.size();
+            }
+        }
+
+        size_t maxRight = 5; /* ' 100%' */
+
+        std::string leftText = align(m.name, maxLeft);
+
+        std::string rightText = align(
+            std::to_string((int)(round(m.brightness * 100.0))) + "%",
+            maxRight);
+
+        int trackWidth = (int) width - ((int) maxRight + (int) maxLeft + 3);
+        int thumbOffset = std::max(0, (int)(m.brightness * (float) trackWidth) - 1);
+        std::string trackText = " ";
+        for (int i = 0; i < trackWidth; i++) {
+            trackText += (i == thumbOffset) ? "■" : "─";
+        }
+
+        return " " + leftText + trackText + rightText;
+    }
+
+    /* the slave end of a pseudo-terminal, and a thread that drains the
+    master end, like a terminal emulator would */
+    class Terminal {
+        public:
+            Terminal() {
+                this->master = posix_openpt(O_RDWR | O_NOCTTY | O_CLOEXEC);
+                if (this->master >= 0 && grantpt(this->master) == 0 && unlockpt(this->master) == 0) {
+                    this->slave = ::open(ptsname(this->master), O_WRONLY | O_NOCTTY | O_CLOEXEC);
+                }
+                if (this->slave >= 0) {
+                    this->thread = std::thread([this]() {
+                        char buffer[64 * 1024];
+                        while (::read(this->master, buffer, sizeof(buffer)) > 0) {
+                        }
+                    });
+                }
+            }
+
+            ~Terminal() {
+                if (this->slave >= 0) {
+                    ::close(this->slave); /* the reader sees EIO */
+                }
+                if (this->thread.joinable()) {
+                    this->thread.join();
+                }
+                if (this->master >= 0) {
+                    ::close(this->master);
+                }
+            }
+
+            bool Ok() const {
+                return this->slave >= 0;
+            }
+
+            void Write(const std::string& data) {
+                size_t offset = 0;
+                while (offset < data.size()) {
+                    ssize_t count = ::write(this->slave, data.data() + offset, data.size() - offset);
+                    if (count <= 0) {
+                        return;
+                    }
+                    offset += (size_t) count;
+                }
+            }
+
+        private:
+            int master = -1, slave = -1;
+            std::thread thread;
+    };
+
+    static std::vector<Monitor> outputs(size_t count) {
+        std::vector<Monitor> result(count);
+        for (size_t i = 0; i < count; i++) {
+            result[i].name = (i % 3 ? "DP-" : "HDMI-A-") + std::to_string(i);
+            result[i].brightness = 0.05f + (float)(i % 20) * 0.05f;
+        }
+        return result;
+    }
+
+    /* `change` is applied before each frame; `row` appends row i's text */
+    static void run(
+        const std::string& name,
+        const Options& options,
+        Terminal& terminal,
+        std::vector<Monitor>& monitors,
+        std::function<void(int)> change,
+        std::function<void(size_t, std::string&)> row)
+    {
+        const int frames = options.iterations * FRAMES_PER_ITERATION;
+        std::string frame;
+        Samples samples, formatting;
+        size_t allocated = 0;
+        for (int f = 0; f < frames; f++) {
+            change(f);
+            size_t before = allocationCount();
+            auto start = Clock::now();
+            frame.assign("\x1b[H");
+            for (size_t i = 0; i < monitors.size(); i++) {
+                row(i, frame);
+                frame.append("\r\n");
+            }
+            formatting.Add(elapsedMs(start));
+            allocated += allocationCount() - before;
+            terminal.Write(frame);
+            samples.Add(elapsedMs(start));
+        }
+        report(name, samples);
+        printf(
+            "  %-40s formatting p50=%.3fms, %.1f allocations per frame\n",
+            "",
+            formatting.Percentile(50.0),
+            (double) allocated / frames);
+    }
+
+    void render(const Options& options) {
+        Terminal terminal;
+        if (!terminal.Ok()) {
+            printf("  couldn't open a pseudo-terminal; skipped\n");
+            return;
+        }
+
+        for (size_t count : OUTPUTS) {
+            auto monitors = outputs(count);
+            const std::string label = std::to_string(count) + " outputs, ";
+
+            ui::RowCache cache;
+            cache.Reset(monitors);
+
+            size_t mismatched = 0;
+            for (size_t i = 0; i < count; i++) {
+                cache.Format(i, WIDTH, monitors[i]);
+                mismatched += (cache.Text(i) != formatRow(WIDTH, monitors, i));
+            }
+            printf("  %zu outputs (%zu rows differ from formatRow)\n", count, mismatched);
+
+            auto nothing = [](int) { };
+
+            auto one = [&](int f) {
+                auto& m = monitors[(size_t) f % count];
+                m.brightness = (m.brightness > 0.5f) ? 0.3f : 0.7f;
+            };
+
+            auto all = [&](int f) {
+                for (auto& m : monitors) {
+                    m.brightness = 0.3f + 0.6f * (float)(f % 60) / 60.0f;
+                }
+            };
+
+            auto uncached = [&](size_t i, std::string& frame) {
+                frame += formatRow(WIDTH, monitors, i);
+            };
+
+            auto cached = [&](size_t i, std::string& frame) {
+                cache.Format(i, WIDTH, monitors[i]);
+                frame += cache.Text(i);
+            };
+
+            run(label + "formatRow, every row", options, terminal, monitors, nothing, uncached);
+            run(label + "RowCache, nothing changed", options, terminal, monitors, nothing, cached);
+            run(label + "RowCache, one changed", options, terminal, monitors, one, cached);
+            run(label + "RowCache, all changed", options, terminal, monitors, all, cached);
+        }
+    }
+} }
@@ -0,0 +1,80 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2019 casey langen
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the author nor the names of other contributors may
+//      be used to endorse or promote products derived from this software
+//      without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include "bench.h"
+
+#include <app/pstream.h>
+
+#include <cstring>
+#include <memory>
+
+/* measures how long it takes from asking pstreams to start a process until
+the first byte of its output arrives, for fork()+exec() vs posix_spawn(), as
+the parent's resident set grows. fork() has to copy the parent's page tables,
+so its cost scales with RSS; posix_spawn() shouldn't. */
+
+namespace bench { namespace suites {
+    static const size_t RSS_MB[] = { 0, 64, 256, 1024 };
+
+    static double firstByte(redi::pstreams::pmode mode) {
+        auto start = Clock::now();
+        redi::ipstream in("echo", { "echo", "x" }, mode);
+        in.get();
+        double ms = elapsedMs(start);
+        in.close();
+        return ms;
+    }
+
+    void spawn(const Options& options) {
+        using redi::pstreams;
+
+        for (size_t mb : RSS_MB) {
+            /* touch every page so it's actually resident (and mapped) */
+            std::unique_ptr<char[]> ballast;
+            if (mb) {
+                ballast.reset(new char[mb * 1024 * 1024]);
+                memset(ballast.get(), 1, mb * 1024 * 1024);
+            }
+
+            Samples forked, spawned;
+            for (int i = 0; i < options.iterations; i++) {
+                forked.Add(firstByte(pstreams::pstdout));
+                spawned.Add(firstByte(pstreams::pstdout | pstreams::spawn));
+            }
+
+            report("fork+exec, rss +" + std::to_string(mb) + "MB", forked);
+            report("posix_spawn, rss +" + std::to_string(mb) + "MB", spawned);
+        }
+    }
+} }
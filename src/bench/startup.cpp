@@ -0,0 +1,141 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2019 casey langen
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the author nor the names of other contributors may
+//      be used to endorse or promote products derived from this software
+//      without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include "bench.h"
+
+#include <climits>
+#include <cstring>
+#include <fcntl.h>
+#include <spawn.h>
+#include <string>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+
+/* exec-to-exit time of xdimmer and xdimmer-cli, i.e. what a key binding pays
+before any real work starts: loading and relocating shared libraries, and
+static initialization. both run `--help`, which doesn't touch the x server,
+a few times to warm the page cache and then once per iteration. cpu time
+and page faults come from wait4()'s rusage; they're the counters `perf stat`
+reports as task-clock and page-faults. the binaries are looked for next to
+this one, i.e. in __output. */
+
+namespace bench { namespace suites {
+    static const int WARMUP_RUNS = 3;
+
+    struct Run {
+        double wallMs;
+        double cpuMs;
+        long faults;
+    };
+
+    static bool run(const std::string& binary, Run& result) {
+        const char* args[] = { binary.c_str(), "--help", nullptr };
+
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+
+        auto start = Clock::now();
+        pid_t pid;
+        int rc = posix_spawn(&pid, binary.c_str(), &actions, nullptr, (char**) args, environ);
+        posix_spawn_file_actions_destroy(&actions);
+        if (rc != 0) {
+            return false;
+        }
+
+        int status;
+        struct rusage usage;
+        if (wait4(pid, &status, 0, &usage) != pid) {
+            return false;
+        }
+        result.wallMs = elapsedMs(start);
+
+        auto ms = [](const timeval& tv) {
+            return tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0;
+        };
+
+        result.cpuMs = ms(usage.ru_utime) + ms(usage.ru_stime);
+        result.faults = usage.ru_minflt + usage.ru_majflt;
+        return true;
+    }
+
+    void startup(const Options& options) {
+        char self[PATH_MAX] = { 0 };
+        if (readlink("/proc/self/exe", self, sizeof(self) - 1) <= 0) {
+            return;
+        }
+
+        std::string dir(self);
+        dir = dir.substr(0, dir.rfind('/') + 1);
+
+        for (const char* name : { "xdimmer", "xdimmer-cli" }) {
+            std::string binary = dir + name;
+            if (access(binary.c_str(), X_OK) != 0) {
+                printf("  %s not found; skipped\n", binary.c_str());
+                continue;
+            }
+
+            Run result;
+            bool ok = true;
+            for (int i = 0; i < WARMUP_RUNS && ok; i++) {
+                ok = run(binary, result);
+            }
+
+            Samples wall, cpu;
+            long faults = 0;
+            for (int i = 0; i < options.iterations && ok; i++) {
+                if ((ok = run(binary, result))) {
+                    wall.Add(result.wallMs);
+                    cpu.Add(result.cpuMs);
+                    faults += result.faults;
+                }
+            }
+
+            if (!ok) {
+                printf("  couldn't run %s; skipped\n", binary.c_str());
+                continue;
+            }
+
+            report(std::string(name) + " --help, exec to exit", wall);
+            report(std::string(name) + " --help, cpu time", cpu);
+            printf(
+                "  %-40s %.1f page faults per run\n",
+                "",
+                (double) faults / options.iterations);
+        }
+    }
+} }
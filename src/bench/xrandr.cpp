@@ -0,0 +1,220 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (c) 2019 casey langen
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//    * Redistributions of source code must retain the above copyright notice,
+//      this list of conditions and the following disclaimer.
+//
+//    * Redistributions in binary form must reproduce the above copyright
+//      notice, this list of conditions and the following disclaimer in the
+//      documentation and/or other materials provided with the distribution.
+//
+//    * Neither the name of the author nor the names of other contributors may
+//      be used to endorse or promote products derived from this software
+//      without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include "bench.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <unistd.h>
+
+/* synthetic `xrandr --verbose` output, and a stand-in xrandr that prints it.
+each output is modelled on the block xrandr 1.5 prints for a laptop panel:
+properties, an EDID hex dump, the transform matrix and a handful of modes
+with their timings. every fourth output is disconnected, and so has no CRTC
+and no modes. */
+
+namespace bench {
+    static const char SCREEN[] =
+        "Screen 0: minimum 320 x 200, current 3840 x 1080, maximum 16384 x 16384\n";
+
+    static const char CONNECTED[] =
+        "%s connected %s1920x1080+%d+0 (0x%x) normal (normal left inverted right x axis y axis) 344mm x 193mm\n"
+        "\tIdentifier: 0x%x\n"
+        "\tTimestamp:  43215\n"
+        "\tSubpixel:   unknown\n"
+        "\tGamma:      1.0:1.0:1.0\n"
+        "\tBrightness: 0.%02d\n"
+        "\tClones:    \n"
+        "\tCRTC:       %d\n"
+        "\tCRTCs:      0 1 2 3\n"
+        "\tTransform:  1.000000 0.000000 0.000000\n"
+        "\t            0.000000 1.000000 0.000000\n"
+        "\t            0.000000 0.000000 1.000000\n"
+        "\t           filter: \n"
+        "\tEDID: \n"
+        "\t\t00ffffffffffff0006af3d5700000000\n"
+        "\t\t001b0104a51f117802f4f5a4544d9c27\n"
+        "\t\t0e505400000001010101010101010101\n"
+        "\t\t010101010101b43780a070383e403020\n"
+        "\t\t350035ae1000001a9d2c80a070383e40\n"
+        "\t\t3020350035ae1000001a000000fe0030\n"
+        "\t\t4a3939418042313430484146000000000\n"
+        "\t\t0002410b2a0011000a010a202000ea\n"
+        "\tscaling mode: Full aspect\n"
+        "\t\tsupported: Full, Center, Full aspect\n"
+        "\tColorspace: Default\n"
+        "\t\tsupported: Default, BT709_YCC, XVYCC_709, SYCC_601, opYCC_601\n"
+        "\tmax bpc: 12\n"
+        "\t\trange: (6, 12)\n"
+        "\tBroadcast RGB: Automatic\n"
+        "\t\tsupported: Automatic, Full, Limited 16:235\n"
+        "\tlink-status: Good\n"
+        "\t\tsupported: Good, Bad\n"
+        "\tnon-desktop: 0 \n"
+        "\t\trange: (0, 1)\n"
+        "  1920x1080 (0x%x) 142.600MHz -HSync -VSync *current +preferred\n"
+        "        h: width  1920 start 1968 end 2000 total 2080 skew    0 clock  68.56KHz\n"
+        "        v: height 1080 start 1083 end 1088 total 1142           clock  60.03Hz\n"
+        "  1920x1080 (0x%x) 95.040MHz -HSync -VSync\n"
+        "        h: width  1920 start 1968 end 2000 total 2080 skew    0 clock  45.69KHz\n"
+        "        v: height 1080 start 1083 end 1088 total 1142           clock  40.01Hz\n"
+        "  1680x1050 (0x%x) 146.250MHz -HSync +VSync\n"
+        "        h: width  1680 start 1784 end 1960 total 2240 skew    0 clock  65.29KHz\n"
+        "        v: height 1050 start 1053 end 1059 total 1089           clock  59.95Hz\n"
+        "  1280x1024 (0x%x) 108.000MHz +HSync +VSync\n"
+        "        h: width  1280 start 1328 end 1440 total 1688 skew    0 clock  63.98KHz\n"
+        "        v: height 1024 start 1025 end 1028 total 1066           clock  60.02Hz\n"
+        "  1024x768 (0x%x) 65.000MHz -HSync -VSync\n"
+        "        h: width  1024 start 1048 end 1184 total 1344 skew    0 clock  48.36KHz\n"
+        "        v: height  768 start  771 end  777 total  806           clock  60.00Hz\n";
+
+    static const char DISCONNECTED[] =
+        "%s disconnected (normal left inverted right x axis y axis)\n"
+        "\tIdentifier: 0x%x\n"
+        "\tTimestamp:  43215\n"
+        "\tSubpixel:   unknown\n"
+        "\tClones:    \n"
+        "\tCRTCs:      0 1 2 3\n"
+        "\tTransform:  1.000000 0.000000 0.000000\n"
+        "\t            0.000000 1.000000 0.000000\n"
+        "\t            0.000000 0.000000 1.000000\n"
+        "\t           filter: \n"
+        "\tlink-status: Good\n"
+        "\t\tsupported: Good, Bad\n"
+        "\tnon-desktop: 0 \n"
+        "\t\trange: (0, 1)\n";
+
+    std::string xrandrVerbose(int outputs) {
+        std::string result = SCREEN;
+        char buffer[sizeof(CONNECTED) + 256];
+        for (int i = 0; i < outputs; i++) {
+            std::string name = "DP-" + std::to_string(i);
+            int id = 0x40 + i * 8;
+            if (i % 4 == 3) {
+                snprintf(buffer, sizeof(buffer), DISCONNECTED, name.c_str(), id);
+            }
+            else {
+                snprintf(
+                    buffer, sizeof(buffer), CONNECTED,
+                    name.c_str(), i ? "" : "primary ", i * 1920, id + 1, id,
+                    50 + i % 50, i, id + 1, id + 2, id + 3, id + 4, id + 5);
+            }
+            result += buffer;
+        }
+        return result;
+    }
+
+    static int envInt(const char* name, int fallback) {
+        const char* value = getenv(name);
+        return value ? atoi(value) : fallback;
+    }
+
+    static void sleepMs(int ms) {
+        if (ms > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+        }
+    }
+
+    int fakeXrandr(int argc, char* argv[]) {
+        bool write = false;
+        int clauses = 0;
+        for (int i = 1; i < argc; i++) {
+            if (!strcmp(argv[i], "--output")) {
+                write = true;
+                ++clauses;
+            }
+        }
+
+        /* one byte per process, so the bench can tell how many we were */
+        const char* log = getenv("XDIMMER_FAKE_LOG");
+        if (log) {
+            int fd = open(log, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0600);
+            if (fd >= 0) {
+                (void) !::write(fd, write ? "w" : "q", 1);
+                close(fd);
+            }
+        }
+
+        const char* exec = getenv("XDIMMER_FAKE_EXEC");
+        if (exec) {
+            execv(exec, argv);
+            perror(exec);
+            return 1;
+        }
+
+        /* roughly what the real thing does: connect to the server and fetch
+        the screen resources, then one or more round trips per output */
+        const int startupMs = envInt("XDIMMER_FAKE_LATENCY_MS", 0);
+        const int outputMs = envInt("XDIMMER_FAKE_OUTPUT_MS", 0);
+
+        sleepMs(startupMs);
+
+        if (write) {
+            sleepMs(outputMs * clauses);
+            return 0;
+        }
+
+        std::string text;
+        const char* script = getenv("XDIMMER_FAKE_SCRIPT");
+        if (script) {
+            std::ifstream in(script);
+            std::stringstream buffer;
+            buffer << in.rdbuf();
+            text = buffer.str();
+        }
+        else {
+            text = xrandrVerbose(envInt("XDIMMER_FAKE_OUTPUTS", 4));
+        }
+
+        /* stdout is left fully buffered, as xrandr's is when it's piped */
+        size_t start = 0;
+        while (start < text.size()) {
+            size_t end = text.find('\n', start);
+            end = (end == std::string::npos) ? text.size() : end + 1;
+            const char* line = text.c_str() + start;
+            if (*line != ' ' && *line != '\t' && strncmp(line, "Screen ", 7)) {
+                sleepMs(outputMs);
+            }
+            fwrite(line, 1, end - start, stdout);
+            start = end;
+        }
+
+        return 0;
+    }
+}